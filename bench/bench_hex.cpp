@@ -0,0 +1,145 @@
+// Compare hex decoders for 🔢 data lines against the stringstream loop they replaced.
+//
+// Usage: bench/bench_hex [--bytes N] [--line-bytes K] [--iterations I]
+// Before timing, every decoder is checked against stringstream on the
+// benchmark lines and on a set of irregular inputs.
+
+#include "hex_decode.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::vector<uint8_t> legacy_decode(std::string_view text)
+{
+    std::vector<uint8_t> bytes;
+    std::stringstream ss { std::string(text) };
+    uint32_t byte;
+    while (ss >> std::hex >> byte) {
+        bytes.push_back(static_cast<uint8_t>(byte));
+    }
+    return bytes;
+}
+
+std::vector<uint8_t> decode(std::string_view text, HexDecoder decoder)
+{
+    std::vector<uint8_t> bytes(hex_decoded_size_bound(text));
+    bytes.resize(decode_hex_bytes(text, bytes.data(), decoder));
+    return bytes;
+}
+
+std::vector<std::string> make_lines(size_t total, size_t per_line)
+{
+    std::mt19937 rng(3);
+    std::vector<std::string> lines;
+    for (size_t done = 0; done < total; done += per_line) {
+        std::string line;
+        for (size_t i = 0; i < per_line; ++i) {
+            char buf[4];
+            snprintf(buf, sizeof(buf), " %02x", static_cast<unsigned>(rng() & 0xff));
+            line += buf;
+        }
+        lines.push_back(std::move(line));
+    }
+    return lines;
+}
+
+const char* decoder_name(HexDecoder d)
+{
+    switch (d) {
+    case HexDecoder::Scalar:
+        return "scalar";
+    case HexDecoder::SSSE3:
+        return "ssse3";
+    case HexDecoder::AVX2:
+        return "avx2";
+    }
+    return "?";
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t total = 16 << 20;
+    size_t per_line = 16;
+    int iterations = 3;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bytes" && i + 1 < argc) {
+            total = std::stoul(argv[++i]);
+        } else if (arg == "--line-bytes" && i + 1 < argc) {
+            per_line = std::stoul(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::stoi(argv[++i]);
+        }
+    }
+
+    std::vector<HexDecoder> decoders = { HexDecoder::Scalar };
+    if (best_hex_decoder() != HexDecoder::Scalar) {
+        decoders.push_back(HexDecoder::SSSE3);
+    }
+    if (best_hex_decoder() == HexDecoder::AVX2) {
+        decoders.push_back(HexDecoder::AVX2);
+    }
+
+    auto lines = make_lines(total, per_line);
+    std::vector<std::string> odd = {
+        "",
+        " 1 2 3",
+        "\t0a\t0b  0c ",
+        " 0x1f 20",
+        " 123 45",
+        " ff zz 01",
+        " 1fz 02",
+        " 100000000 01",
+        " aa bb cc dd ee ff 00 11 22 33 44 55 66 77 88 99 aa bb cc dd ee ff 00 11 22 33 44 55 66 77 88 9g",
+        " AA BB CC DD EE FF 00 11 22 33 44 55 66 77 88 99 aa bb cc dd ee ff 00 11 22 33 44 55 66 77 88 99 1",
+    };
+    odd.insert(odd.end(), lines.begin(), lines.begin() + std::min<size_t>(lines.size(), 1000));
+    for (const auto& line : odd) {
+        auto expected = legacy_decode(line);
+        for (auto d : decoders) {
+            if (decode(line, d) != expected) {
+                std::cerr << decoder_name(d) << " disagrees with stringstream on \"" << line << "\"" << std::endl;
+                return 1;
+            }
+        }
+    }
+
+    auto time = [&](auto&& body) {
+        double best = 1e300;
+        for (int i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto stop = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(stop - start).count());
+        }
+        return best;
+    };
+    auto report = [&](const char* name, double seconds) {
+        printf("  %-12s %9.1f ms %9.1f MiB/s\n", name, seconds * 1e3, total / seconds / (1 << 20));
+    };
+
+    printf("%zu bytes, %zu per line\n", total, per_line);
+    size_t sink = 0;
+    report("stringstream", time([&] {
+        for (const auto& line : lines)
+            sink += legacy_decode(line).size();
+    }));
+    std::vector<uint8_t> out(total + 64);
+    for (auto d : decoders) {
+        report(decoder_name(d), time([&] {
+            size_t pos = 0;
+            for (const auto& line : lines)
+                pos += decode_hex_bytes(line, out.data() + pos, d);
+            sink += pos;
+        }));
+    }
+    return sink == 0;
+}
@@ -0,0 +1,174 @@
+// Compare the streaming JSON loader against the DOM-based reference loader.
+//
+// Usage: bench/bench_load [--functions N] [--iterations K] [input.fo ...]
+// Without inputs a synthetic relocation-dense object is generated first.
+// Each loader runs in its own child process so peak RSS is measured per loader.
+
+#include "fle.hpp"
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+
+struct Result {
+    double best_ms;
+    long peak_rss_kb;
+};
+
+std::string write_synthetic_object(size_t functions)
+{
+    std::string path = "/tmp/bench_load_" + std::to_string(getpid()) + ".fo";
+    std::mt19937 rng(42);
+    std::ofstream out(path);
+    out << "{\n    \"type\": \".obj\",\n    \".text\": [\n";
+    bool first = true;
+    auto line = [&](const std::string& s) {
+        out << (first ? "" : ",\n") << "        \"" << s << "\"";
+        first = false;
+    };
+    size_t offset = 0;
+    for (size_t f = 0; f < functions; ++f) {
+        line("📤: func_" + std::to_string(f) + " 64 " + std::to_string(offset));
+        for (int chunk = 0; chunk < 3; ++chunk) {
+            std::string hex = "🔢:";
+            for (int i = 0; i < 16; ++i) {
+                char buf[4];
+                snprintf(buf, sizeof(buf), " %02x", static_cast<unsigned>(rng() & 0xff));
+                hex += buf;
+            }
+            line(hex);
+            offset += 16;
+            line("❓: .rel(func_" + std::to_string(rng() % functions) + " - 4)");
+            offset += 4;
+        }
+        line("❓: .abs64(data_" + std::to_string(f % 64) + " + 0x10)");
+        offset += 8;
+    }
+    out << "\n    ]\n}\n";
+    return path;
+}
+
+Result run_isolated(const std::function<void()>& load, int iterations)
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        throw std::runtime_error("pipe failed");
+    }
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        double best = 1e300;
+        for (int i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            load();
+            auto stop = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+        }
+        if (write(fds[1], &best, sizeof(best)) != sizeof(best)) {
+            _exit(1);
+        }
+        _exit(0);
+    }
+    close(fds[1]);
+    double best = 0;
+    if (read(fds[0], &best, sizeof(best)) != sizeof(best)) {
+        throw std::runtime_error("benchmark child failed");
+    }
+    close(fds[0]);
+    int status = 0;
+    struct rusage usage {};
+    wait4(pid, &status, 0, &usage);
+    return { best, usage.ru_maxrss };
+}
+
+bool same_object(const FLEObject& a, const FLEObject& b)
+{
+    if (a.type != b.type || a.sections.size() != b.sections.size() || a.symbols.size() != b.symbols.size()
+        || a.members.size() != b.members.size() || a.dyn_relocs.size() != b.dyn_relocs.size()) {
+        return false;
+    }
+    for (const auto& [name, sec] : a.sections) {
+        auto it = b.sections.find(name);
+        if (it == b.sections.end() || sec.relocs.size() != it->second.relocs.size()
+            || !std::equal(sec.data.begin(), sec.data.end(), it->second.data.begin(), it->second.data.end())) {
+            return false;
+        }
+        for (size_t i = 0; i < sec.relocs.size(); ++i) {
+            const auto& x = sec.relocs[i];
+            const auto& y = it->second.relocs[i];
+            if (x.type != y.type || x.offset != y.offset || x.symbol != y.symbol || x.addend != y.addend) {
+                return false;
+            }
+        }
+    }
+    for (size_t i = 0; i < a.symbols.size(); ++i) {
+        const auto& x = a.symbols[i];
+        const auto& y = b.symbols[i];
+        if (x.type != y.type || x.name != y.name || x.section != y.section || x.offset != y.offset
+            || x.size != y.size) {
+            return false;
+        }
+    }
+    for (size_t i = 0; i < a.members.size(); ++i) {
+        FLEObject x = a.members[i];
+        FLEObject y = b.members[i];
+        materialize_member(x);
+        materialize_member(y);
+        if (!same_object(x, y)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t functions = 20000;
+    int iterations = 3;
+    std::vector<std::string> inputs;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--functions" && i + 1 < argc) {
+            functions = std::stoul(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::stoi(argv[++i]);
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    bool synthetic = inputs.empty();
+    if (synthetic) {
+        inputs.push_back(write_synthetic_object(functions));
+    }
+
+    for (const auto& file : inputs) {
+        if (!same_object(load_fle(file), load_fle_dom(file))) {
+            std::cerr << file << ": streaming and DOM loaders disagree" << std::endl;
+            return 1;
+        }
+
+        std::ifstream in(file, std::ios::binary | std::ios::ate);
+        std::cout << file << " (" << in.tellg() / 1024 << " KiB)" << std::endl;
+
+        Result dom = run_isolated([&] { load_fle_dom(file); }, iterations);
+        Result stream = run_isolated([&] { load_fle(file); }, iterations);
+        printf("  %-10s %10.1f ms %10ld KiB peak RSS\n", "dom", dom.best_ms, dom.peak_rss_kb);
+        printf("  %-10s %10.1f ms %10ld KiB peak RSS\n", "streaming", stream.best_ms, stream.peak_rss_kb);
+        printf("  speedup %.2fx, RSS %.2fx lower\n", dom.best_ms / stream.best_ms,
+            static_cast<double>(dom.peak_rss_kb) / stream.peak_rss_kb);
+    }
+
+    if (synthetic) {
+        std::remove(inputs.front().c_str());
+    }
+    return 0;
+}
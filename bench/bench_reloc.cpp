@@ -0,0 +1,187 @@
+// Compare the relocation engine against the per-relocation switch it replaced:
+// "engine" goes through a RelocBatch, "direct" calls apply_reloc per site.
+//
+// Usage: bench/bench_reloc [--relocs N] [--iterations I]
+// Before timing, the engine is checked against the old byte loops on random
+// in-range relocations of every type, and must reject out-of-range values.
+
+#include "reloc_engine.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Case {
+    RelocationType type;
+    RelocSite site;
+};
+
+constexpr RelocationType TYPES[] = {
+    RelocationType::R_X86_64_32,
+    RelocationType::R_X86_64_PC32,
+    RelocationType::R_X86_64_64,
+    RelocationType::R_X86_64_32S,
+    RelocationType::R_X86_64_GOTPCREL,
+};
+
+// The loops ld used before the engine
+void legacy_apply(const std::vector<Case>& cases)
+{
+    for (const auto& c : cases) {
+        const RelocSite& r = c.site;
+        switch (c.type) {
+        case RelocationType::R_X86_64_32:
+        case RelocationType::R_X86_64_32S: {
+            uint32_t val = (uint32_t)(r.S + r.A);
+            for (int i = 0; i < 4; i++)
+                r.loc[i] = (val >> 8 * i) & 0xff;
+            break;
+        }
+        case RelocationType::R_X86_64_PC32:
+        case RelocationType::R_X86_64_GOTPCREL: {
+            int32_t val = (int32_t)(r.S + r.A - r.P);
+            for (int i = 0; i < 4; i++)
+                r.loc[i] = (val >> 8 * i) & 0xff;
+            break;
+        }
+        case RelocationType::R_X86_64_64: {
+            uint64_t val = (uint64_t)(r.S + r.A);
+            for (int i = 0; i < 8; i++)
+                r.loc[i] = (val >> 8 * i) & 0xff;
+            break;
+        }
+        }
+    }
+}
+
+void engine_apply(const std::vector<Case>& cases)
+{
+    static RelocBatch batch; // Reused like ld's per-thread batches, so bucket capacity is kept
+    for (const auto& c : cases) {
+        batch.add(c.type, c.site);
+    }
+    batch.apply();
+}
+
+void direct_apply(const std::vector<Case>& cases)
+{
+    for (const auto& c : cases) {
+        apply_reloc(c.type, c.site);
+    }
+}
+
+// One relocation every 8 bytes of `image`, addresses near 0x400000
+std::vector<Case> make_cases(std::vector<uint8_t>& image, size_t count, std::mt19937_64& rng)
+{
+    image.assign(count * 8, 0);
+    std::vector<Case> cases;
+    for (size_t i = 0; i < count; ++i) {
+        RelocationType type = TYPES[rng() % 5];
+        uint64_t P = 0x400000 + i * 8;
+        uint64_t S = 0x400000 + rng() % 0x1000000;
+        int64_t A = static_cast<int64_t>(rng() % 64) - 32;
+        cases.push_back({ type, { image.data() + i * 8, P, S, A, nullptr } });
+    }
+    return cases;
+}
+
+bool overflows(RelocationType type, uint64_t S, int64_t A, uint64_t P)
+{
+    uint8_t buf[8] = {};
+    RelocBatch batch;
+    batch.add(type, { buf, P, S, A, nullptr });
+    try {
+        batch.apply();
+    } catch (const std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t count = 1 << 20;
+    int iterations = 5;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--relocs" && i + 1 < argc) {
+            count = std::stoul(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::stoi(argv[++i]);
+        }
+    }
+
+    std::mt19937_64 rng(7);
+    std::vector<uint8_t> expected_image, image;
+    auto cases = make_cases(expected_image, count, rng);
+    legacy_apply(cases);
+    image.assign(expected_image.size(), 0);
+    for (auto& c : cases) {
+        c.site.loc = image.data() + (c.site.loc - expected_image.data());
+    }
+    engine_apply(cases);
+    if (image != expected_image) {
+        std::cerr << "engine disagrees with the byte loops" << std::endl;
+        return 1;
+    }
+    std::fill(image.begin(), image.end(), 0);
+    direct_apply(cases);
+    if (image != expected_image) {
+        std::cerr << "apply_reloc disagrees with the byte loops" << std::endl;
+        return 1;
+    }
+
+    struct Limit {
+        RelocationType type;
+        uint64_t S;
+        int64_t A;
+        uint64_t P;
+        bool overflow;
+    };
+    const Limit limits[] = {
+        { RelocationType::R_X86_64_32, 0xffffffff, 0, 0, false },
+        { RelocationType::R_X86_64_32, 0xffffffff, 1, 0, true },
+        { RelocationType::R_X86_64_32, 0, -1, 0, true },
+        { RelocationType::R_X86_64_32S, 0x7fffffff, 0, 0, false },
+        { RelocationType::R_X86_64_32S, 0x80000000, 0, 0, true },
+        { RelocationType::R_X86_64_32S, 0, -0x80000000ll, 0, false },
+        { RelocationType::R_X86_64_PC32, 0x80000000, -4, 0x4, false },
+        { RelocationType::R_X86_64_PC32, 0x80000000, 0, 0, true },
+        { RelocationType::R_X86_64_GOTPCREL, 0, 0, 0x80000001, true },
+        { RelocationType::R_X86_64_64, ~0ull, 0, 0, false },
+    };
+    for (const auto& l : limits) {
+        if (overflows(l.type, l.S, l.A, l.P) != l.overflow) {
+            std::cerr << "wrong overflow check for type " << static_cast<int>(l.type) << " S=" << l.S
+                      << " A=" << l.A << " P=" << l.P << std::endl;
+            return 1;
+        }
+    }
+
+    auto time = [&](auto&& body) {
+        double best = 1e300;
+        for (int i = 0; i < iterations; ++i) {
+            auto start = std::chrono::steady_clock::now();
+            body();
+            auto stop = std::chrono::steady_clock::now();
+            best = std::min(best, std::chrono::duration<double>(stop - start).count());
+        }
+        return best;
+    };
+    auto report = [&](const char* name, double seconds) {
+        printf("  %-8s %9.2f ms %9.1f M relocs/s\n", name, seconds * 1e3, count / seconds / 1e6);
+    };
+
+    printf("%zu relocations\n", count);
+    report("switch", time([&] { legacy_apply(cases); }));
+    report("engine", time([&] { engine_apply(cases); }));
+    report("direct", time([&] { direct_apply(cases); }));
+    return 0;
+}
@@ -0,0 +1,203 @@
+// Compare the section line tokenizer against the regex/istringstream code it replaced.
+//
+// Usage: bench/bench_tokenizer [--lines N] [--iterations K]
+// Lines are a synthetic mix of symbol labels and relocations; 🔢 lines are
+// left out since both versions decode them the same way.
+
+#include "fle_tokenizer.hpp"
+#include "string_utils.hpp"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <random>
+#include <regex>
+#include <sstream>
+
+namespace {
+
+struct ParsedLine {
+    char kind = '?'; // 's' symbol, 'r' relocation, '?' other
+    std::string name;
+    size_t size = 0;
+    size_t offset = 0;
+    RelocationType type = RelocationType::R_X86_64_PC32;
+    int64_t addend = 0;
+
+    bool operator==(const ParsedLine& o) const
+    {
+        return kind == o.kind && name == o.name && size == o.size && offset == o.offset && type == o.type
+            && addend == o.addend;
+    }
+};
+
+// ---- previous implementation, kept verbatim as the baseline ----
+
+RelocationType legacy_relocation_type(const std::string& type_str)
+{
+    if (type_str == "rel" || type_str == "dynrel")
+        return RelocationType::R_X86_64_PC32;
+    if (type_str == "abs64" || type_str == "dynabs64")
+        return RelocationType::R_X86_64_64;
+    if (type_str == "abs" || type_str == "dynabs32" || type_str == "abs32")
+        return RelocationType::R_X86_64_32;
+    if (type_str == "abs32s")
+        return RelocationType::R_X86_64_32S;
+    if (type_str == "gotpcrel")
+        return RelocationType::R_X86_64_GOTPCREL;
+    throw std::runtime_error("Invalid relocation type: " + type_str);
+}
+
+int64_t legacy_addend_literal(std::string literal)
+{
+    literal = trim(literal);
+    if (literal.size() > 2 && literal[0] == '0' && (literal[1] == 'x' || literal[1] == 'X')) {
+        literal = literal.substr(2);
+    }
+    try {
+        return std::stoll(literal, nullptr, 16);
+    } catch (const std::invalid_argument&) {
+        return std::stoll(literal, nullptr, 10);
+    }
+}
+
+ParsedLine legacy_parse(const std::string& line_str)
+{
+    ParsedLine out;
+    size_t colon_pos = line_str.find(':');
+    std::string prefix = line_str.substr(0, colon_pos);
+    std::string content = line_str.substr(colon_pos + 1);
+
+    if (prefix == "🏷️" || prefix == "📎" || prefix == "📤") {
+        std::istringstream ss(content);
+        ss >> out.name >> out.size >> out.offset;
+        out.name = trim(out.name);
+        out.kind = 's';
+    } else if (prefix == "❓") {
+        std::string reloc_str = trim(content);
+        std::regex reloc_pattern(
+            R"(\.(rel|abs64|abs|abs32s|gotpcrel|dynrel|dynabs64|dynabs32)\(([\w.@$]+)\s*([-+])\s*([0-9a-fA-FxX]+)\))");
+        std::smatch match;
+        if (!std::regex_match(reloc_str, match, reloc_pattern)) {
+            throw std::runtime_error("Invalid relocation: " + reloc_str);
+        }
+        out.kind = 'r';
+        out.type = legacy_relocation_type(match[1].str());
+        out.name = match[2].str();
+        out.addend = legacy_addend_literal(match[4].str());
+        if (match[3].str() == "-") {
+            out.addend = -out.addend;
+        }
+    }
+    return out;
+}
+
+// ---- current implementation ----
+
+ParsedLine tokenizer_parse(std::string_view line)
+{
+    ParsedLine out;
+    std::string_view content;
+    switch (classify_line(line, content)) {
+    case LineKind::LocalSymbol:
+    case LineKind::WeakSymbol:
+    case LineKind::GlobalSymbol: {
+        SymbolToken token;
+        if (parse_symbol_line(content, token)) {
+            out.kind = 's';
+            out.name = std::string(token.name);
+            out.size = token.size;
+            out.offset = token.offset;
+        }
+        break;
+    }
+    case LineKind::Relocation: {
+        RelocToken token;
+        if (!parse_reloc_line(content, token)) {
+            throw std::runtime_error("Invalid relocation: " + std::string(content));
+        }
+        out.kind = 'r';
+        out.type = token.type;
+        out.name = std::string(token.symbol);
+        out.addend = token.addend;
+        break;
+    }
+    default:
+        break;
+    }
+    return out;
+}
+
+std::vector<std::string> make_lines(size_t count)
+{
+    static const char* kinds[] = { "rel", "abs", "abs64", "abs32s", "gotpcrel", "dynrel", "dynabs64", "dynabs32" };
+    static const char* prefixes[] = { "🏷️", "📎", "📤" };
+    std::mt19937 rng(7);
+    std::vector<std::string> lines;
+    lines.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string sym = "sym_" + std::to_string(rng() % 100000);
+        if (i % 4 == 0) {
+            lines.push_back(std::string(prefixes[rng() % 3]) + ": " + sym + " " + std::to_string(rng() % 512) + " "
+                + std::to_string(rng() % 65536));
+        } else {
+            char addend[32];
+            snprintf(addend, sizeof(addend), (rng() & 1) ? "0x%x" : "%x", static_cast<unsigned>(rng() % 4096));
+            lines.push_back(std::string("❓: .") + kinds[rng() % 8] + "(" + sym + ((rng() & 1) ? " - " : " + ")
+                + addend + ")");
+        }
+    }
+    return lines;
+}
+
+template <typename F>
+double best_of(int iterations, F&& body)
+{
+    double best = 1e300;
+    for (int i = 0; i < iterations; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        body();
+        auto stop = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double, std::milli>(stop - start).count());
+    }
+    return best;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    size_t count = 50000;
+    int iterations = 3;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--lines" && i + 1 < argc) {
+            count = std::stoul(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = std::stoi(argv[++i]);
+        }
+    }
+
+    auto lines = make_lines(count);
+    for (const auto& line : lines) {
+        if (!(legacy_parse(line) == tokenizer_parse(line))) {
+            std::cerr << "mismatch on line: " << line << std::endl;
+            return 1;
+        }
+    }
+
+    size_t sink = 0;
+    double legacy = best_of(iterations, [&] {
+        for (const auto& line : lines)
+            sink += legacy_parse(line).addend;
+    });
+    double current = best_of(iterations, [&] {
+        for (const auto& line : lines)
+            sink += tokenizer_parse(line).addend;
+    });
+
+    printf("%zu lines\n", count);
+    printf("  %-10s %10.1f ms %8.0f ns/line\n", "regex", legacy, legacy * 1e6 / count);
+    printf("  %-10s %10.1f ms %8.0f ns/line\n", "tokenizer", current, current * 1e6 / count);
+    printf("  speedup %.1fx (checksum %zu)\n", legacy / current, sink);
+    return 0;
+}
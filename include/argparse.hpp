@@ -97,7 +97,12 @@ public:
                         throw std::runtime_error("Option " + arg + " requires an argument");
                     }
                 }
-                // 3. 检查是否是 粘连 Option (如 -lmath)
+                // 3. 检查是否是 name=value 形式的 Option (如 --icf=all、-Map=out.map)
+                else if (arg.find('=') != std::string::npos && option_map.count(arg.substr(0, arg.find('=')))) {
+                    size_t eq = arg.find('=');
+                    option_map[arg.substr(0, eq)](arg.substr(eq + 1));
+                }
+                // 4. 检查是否是 粘连 Option (如 -lmath)
                 else {
                     bool handled = false;
                     for (char c : short_options) {
@@ -114,7 +119,7 @@ public:
                         throw std::runtime_error("Unknown option: " + arg);
                 }
             } else {
-                // 4. 位置参数
+                // 5. 位置参数
                 if (positional_callback) {
                     positional_callback(arg);
                 } else {
@@ -3,11 +3,15 @@
 #ifndef FLE_HPP
 #define FLE_HPP
 
+#include "interned_string.hpp"
 #include "nlohmann/json.hpp"
 #include <cstdint>
 #include <fstream>
 #include <map>
+#include <memory>
 #include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using json = nlohmann::ordered_json;
@@ -25,7 +29,7 @@ enum class RelocationType {
 struct Relocation {
     RelocationType type;
     size_t offset; // Relocation position
-    std::string symbol; // Symbol to relocate
+    InternedString symbol; // Symbol to relocate
     int64_t addend; // Relocation addend
 };
 
@@ -40,15 +44,119 @@ enum class SymbolType {
 // Symbol entry
 struct Symbol {
     SymbolType type;
-    std::string section; // Section containing the symbol
+    InternedString section; // Section containing the symbol
     size_t offset; // Offset within section
     size_t size; // Symbol size
-    std::string name; // Symbol name
+    InternedString name; // Symbol name
+};
+
+/**
+ * Section payload bytes.
+ *
+ * Behaves like a std::vector<uint8_t>, but can also borrow bytes that live in
+ * a memory-mapped binary FLE file. Read-only access never copies; the first
+ * non-const access to borrowed bytes copies them into owned storage.
+ */
+class SectionData {
+public:
+    using value_type = uint8_t;
+    using iterator = uint8_t*;
+    using const_iterator = const uint8_t*;
+
+    SectionData() = default;
+    SectionData(std::vector<uint8_t> bytes)
+        : storage(std::move(bytes))
+    {
+    }
+
+    // Borrow [ptr, ptr + size); `owner` keeps the underlying mapping alive
+    static SectionData borrow(const uint8_t* ptr, size_t size, std::shared_ptr<const void> owner)
+    {
+        SectionData result;
+        result.view = ptr;
+        result.view_size = size;
+        result.owner = std::move(owner);
+        return result;
+    }
+
+    bool is_borrowed() const { return owner != nullptr; }
+
+    size_t size() const { return owner ? view_size : storage.size(); }
+    bool empty() const { return size() == 0; }
+
+    const uint8_t* data() const { return owner ? view : storage.data(); }
+    const_iterator begin() const { return data(); }
+    const_iterator end() const { return data() + size(); }
+    const uint8_t& operator[](size_t i) const { return data()[i]; }
+
+    uint8_t* data()
+    {
+        own();
+        return storage.data();
+    }
+    iterator begin() { return data(); }
+    iterator end() { return data() + size(); }
+    uint8_t& operator[](size_t i) { return data()[i]; }
+
+    void reserve(size_t n)
+    {
+        own();
+        storage.reserve(n);
+    }
+    void resize(size_t n, uint8_t value = 0)
+    {
+        own();
+        storage.resize(n, value);
+    }
+    void clear()
+    {
+        owner.reset();
+        view = nullptr;
+        view_size = 0;
+        storage.clear();
+    }
+    void push_back(uint8_t byte)
+    {
+        own();
+        storage.push_back(byte);
+    }
+    // pos may point into the borrowed view: take the index before own() replaces it
+    void insert(const_iterator pos, size_t count, uint8_t value)
+    {
+        size_t index = pos - std::as_const(*this).data();
+        own();
+        storage.insert(storage.begin() + index, count, value);
+    }
+    template <typename It>
+    void insert(const_iterator pos, It first, It last)
+    {
+        auto keep_alive = owner; // [first, last) may point into our own view
+        size_t index = pos - std::as_const(*this).data();
+        own();
+        storage.insert(storage.begin() + index, first, last);
+    }
+
+private:
+    void own()
+    {
+        if (!owner) {
+            return;
+        }
+        storage.assign(view, view + view_size);
+        owner.reset();
+        view = nullptr;
+        view_size = 0;
+    }
+
+    std::vector<uint8_t> storage;
+    const uint8_t* view = nullptr;
+    size_t view_size = 0;
+    std::shared_ptr<const void> owner;
 };
 
 struct FLESection {
-    std::string name;
-    std::vector<uint8_t> data; // Section data (stored as bytes)
+    InternedString name;
+    SectionData data; // Section data (stored as bytes)
     std::vector<Relocation> relocs; // Relocation table for this section
     bool has_symbols; // Whether section contains symbols
 };
@@ -64,6 +172,8 @@ enum class SHF { // Section Header Flags
     WRITE = 2, // Writable
     EXEC = 4, // Executable
     NOBITS = 8, // Takes no space in file (like BSS)
+    MERGE = 16, // Fixed-size entries that may be deduplicated (entsize in the header)
+    STRINGS = 32, // With MERGE: NUL-terminated strings of entsize-wide characters
 };
 
 // ================= PHF (Program Header Flags) =================
@@ -138,6 +248,8 @@ struct SectionHeader {
     uint64_t addr; // Virtual address
     uint64_t offset; // File offset
     uint64_t size; // Section size
+    uint64_t entsize = 0; // Entry size of SHF::MERGE sections, 0 otherwise
+    uint64_t align = 0; // Required alignment (a power of two); 0 or 1 means none
 };
 
 struct ProgramHeader {
@@ -147,18 +259,24 @@ struct ProgramHeader {
     uint32_t flags; // Permissions
 };
 
+struct FLEMemberSource; // 归档成员在映射文件中的原始文本（定义见 loader.cpp）
+
 struct FLEObject {
-    std::string name; // Object name
+    InternedString name; // Object name
     std::string type; // ".obj", ".exe", ".ar" or ".so"
-    std::map<std::string, FLESection> sections; // Section name -> section data
+    std::map<InternedString, FLESection> sections; // Section name -> section data
     std::vector<Symbol> symbols; // Global symbol table
     std::vector<ProgramHeader> phdrs; // Program headers (for .exe)
     std::vector<SectionHeader> shdrs; // Section headers
     std::vector<FLEObject> members; // Members of archive
+    std::unordered_map<InternedString, std::vector<size_t>> symbol_index; // For .ar: defined symbol -> members defining it
     size_t entry = 0; // Entry point (for .exe)
 
     std::vector<std::string> needed; // List of shared libraries this object depends on (e.g., "libfoo.so")
     std::vector<Relocation> dyn_relocs; // Dynamic relocations
+
+    // 惰性归档成员：load_fle 只解析了 symbols 和节头，其余内容由 materialize_member() 按需解析
+    std::shared_ptr<const FLEMemberSource> lazy_source;
 };
 
 class FLEWriter {
@@ -224,6 +342,12 @@ public:
             shdr_json["addr"] = shdr.addr;
             shdr_json["offset"] = shdr.offset;
             shdr_json["size"] = shdr.size;
+            if (shdr.entsize != 0) {
+                shdr_json["entsize"] = shdr.entsize;
+            }
+            if (shdr.align > 1) {
+                shdr_json["align"] = shdr.align;
+            }
             shdrs_json.push_back(shdr_json);
         }
         result["shdrs"] = shdrs_json;
@@ -258,8 +382,15 @@ inline std::vector<uint8_t> generate_plt_stub(int32_t got_offset)
 
 // Core functions that we provide
 FLEObject load_fle(const std::string& filename); // Load FLE file into memory
+FLEObject load_fle_dom(const std::string& filename); // Reference JSON loader that builds a full DOM (for benchmarks)
+void materialize_member(FLEObject& member); // Parse the sections of a lazily loaded archive member in place
 void FLE_cc(const std::vector<std::string>& args); // Compile source files to FLE
 
+// Binary FLE container (see src/base/binfle.cpp)
+bool is_binary_fle(const std::string& filename); // Check the file's magic
+FLEObject load_fle_binary(const std::string& filename); // mmap the file; section data is borrowed, not copied
+void FLE_write_binary(const FLEObject& obj, const std::string& filename);
+
 // Functions for students to implement
 /**
  * Display the contents of an FLE object file
@@ -293,20 +424,46 @@ void FLE_nm(const FLEObject& obj);
  */
 void FLE_exec(const FLEObject& obj);
 
+// --icf 模式：不折叠 / 折叠所有内容相同的只读节 / 只折叠地址不会被比较的函数
+enum class ICFMode {
+    NONE,
+    ALL,
+    SAFE
+};
+
+// --call-graph-profile 的一行：调用者、被调用者和调用次数
+struct CallGraphProfileEntry {
+    std::string caller;
+    std::string callee;
+    uint64_t count;
+};
+
 struct LinkerOptions {
     std::string outputFile = "a.out"; // 输出文件名 (用于设置 .so 的 name 属性)
     bool shared = false; // 是否生成共享库 (-shared)
     std::string entryPoint = "_start"; // 入口点名称 (默认为 _start)
     bool is_static = false; // 是否强制静态链接 (-static)
+    size_t threads = 0; // 加载输入和重定位的工作线程数 (-j/--threads)，0 表示每个 CPU 一个
+    bool verbose = false; // 在 stderr 上报告各阶段耗时 (--verbose)
+    bool incremental = false; // 保存链接状态，之后只重链变化的输入 (--incremental)
+    bool gc_sections = false; // 丢弃从入口和导出符号经重定位不可达的输入节 (--gc-sections)
+    ICFMode icf = ICFMode::NONE; // 折叠内容相同的 .text/.rodata 输入节 (--icf=all|safe)
+    std::vector<std::string> symbol_ordering; // 这些符号所在的 .text/.rodata 输入节按此顺序排在最前 (--symbol-ordering-file)
+    std::vector<CallGraphProfileEntry> call_graph_profile; // 按调用图聚类排列 .text 输入节 (--call-graph-profile)
+    size_t align_functions = 0; // .text 输入节至少按此对齐 (--align-functions)，0 表示只按节头
+    std::string map_file; // 链接映射写到这里 (-Map=FILE)，空表示不写
 };
 
+struct LinkState; // link_state.hpp
+
 /**
  * Link multiple FLE objects into an executable or shared library
  * @param objects Vector of FLE objects to link
  * @param options Linker configuration options
+ * @param state If not null, receives the layout for a later incremental relink
  * @return A new FLE object (type ".exe" or ".so")
  */
-FLEObject FLE_ld(const std::vector<FLEObject>& objects, const LinkerOptions& options);
+FLEObject FLE_ld(const std::vector<FLEObject>& objects, const LinkerOptions& options, LinkState* state = nullptr);
 
 /**
  * Read FLE object file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "fle.hpp"
+#include <cstdint>
+#include <string_view>
+
+/*
+ * On-disk cache of parsed FLE objects (see src/base/fle_cache.cpp)
+ *
+ * Enabled by setting FLE_CACHE_DIR. Entries are binary FLE images named after
+ * a hash of the source file's bytes, so an unchanged input is mapped instead
+ * of re-parsed no matter where it lives. FLE_CACHE_MAX_SIZE bounds the
+ * directory (bytes, K/M/G suffixes allowed, default 1G); least recently used
+ * entries are evicted first.
+ */
+
+struct FLECacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t evictions = 0;
+};
+
+bool fle_cache_enabled();
+
+// Hit: fills `obj` from the cache and returns true. `content` is the source file.
+bool fle_cache_lookup(std::string_view content, FLEObject& obj);
+
+// Store the parsed form of `content`; failures only cost a later miss
+void fle_cache_store(std::string_view content, const FLEObject& obj);
+
+// Counters for this process
+FLECacheStats fle_cache_stats();
+
+// 64-bit content hash used for cache keys
+uint64_t fle_content_hash(std::string_view data);
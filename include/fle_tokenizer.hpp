@@ -0,0 +1,242 @@
+#pragma once
+
+#include "fle.hpp"
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Single-pass tokenizer for FLE section lines:
+ *
+ *   🔢: 55 48 89 e5           data bytes
+ *   ❓: .rel(foo - 4)         relocation (also .abs, .abs64, .abs32s, .gotpcrel, .dyn*)
+ *   🏷️: name size offset      local symbol
+ *   📎: name size offset      weak symbol
+ *   📤: name size offset      global symbol
+ *
+ * Nothing here allocates; every token is a view into the line.
+ */
+
+enum class LineKind {
+    Data,
+    Relocation,
+    LocalSymbol,
+    WeakSymbol,
+    GlobalSymbol,
+    Unknown,
+};
+
+struct LinePrefix {
+    std::string_view bytes; // UTF-8 encoding of the emoji
+    LineKind kind;
+};
+
+// Every prefix starts with 0xE2 or 0xF0, so the first byte rejects most mismatches
+constexpr std::array<LinePrefix, 5> LINE_PREFIXES = { {
+    { "\xF0\x9F\x94\xA2", LineKind::Data }, // 🔢
+    { "\xE2\x9D\x93", LineKind::Relocation }, // ❓
+    { "\xF0\x9F\x8F\xB7\xEF\xB8\x8F", LineKind::LocalSymbol }, // 🏷️
+    { "\xF0\x9F\x93\x8E", LineKind::WeakSymbol }, // 📎
+    { "\xF0\x9F\x93\xA4", LineKind::GlobalSymbol }, // 📤
+} };
+
+/**
+ * Classify a line by its prefix (everything before the first ':')
+ * @param content Set to the text after the ':'
+ */
+inline LineKind classify_line(std::string_view line, std::string_view& content)
+{
+    size_t colon = line.find(':');
+    std::string_view prefix = line.substr(0, colon);
+    content = colon == std::string_view::npos ? line : line.substr(colon + 1);
+    if (prefix.empty() || (prefix[0] != '\xE2' && prefix[0] != '\xF0')) {
+        return LineKind::Unknown;
+    }
+    for (const auto& entry : LINE_PREFIXES) {
+        if (prefix == entry.bytes) {
+            return entry.kind;
+        }
+    }
+    return LineKind::Unknown;
+}
+
+namespace fle_tokenizer_detail {
+
+inline bool is_blank(char c) { return c == ' ' || c == '\t'; }
+
+inline void skip_blanks(std::string_view& s)
+{
+    size_t i = 0;
+    while (i < s.size() && is_blank(s[i])) {
+        ++i;
+    }
+    s.remove_prefix(i);
+}
+
+inline int hex_value(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+inline bool is_symbol_char(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '.'
+        || c == '@' || c == '$';
+}
+
+// Non-blank run at the front of `s`
+inline std::string_view take_word(std::string_view& s)
+{
+    skip_blanks(s);
+    size_t n = 0;
+    while (n < s.size() && !is_blank(s[n])) {
+        ++n;
+    }
+    std::string_view word = s.substr(0, n);
+    s.remove_prefix(n);
+    return word;
+}
+
+inline bool parse_decimal(std::string_view word, size_t& value)
+{
+    if (word.empty()) {
+        return false;
+    }
+    value = 0;
+    for (char c : word) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<size_t>(c - '0');
+    }
+    return true;
+}
+
+struct RelocKeyword {
+    std::string_view name;
+    RelocationType type;
+    bool dynamic;
+};
+
+constexpr std::array<RelocKeyword, 8> RELOC_KEYWORDS = { {
+    { "rel", RelocationType::R_X86_64_PC32, false },
+    { "abs", RelocationType::R_X86_64_32, false },
+    { "abs64", RelocationType::R_X86_64_64, false },
+    { "abs32s", RelocationType::R_X86_64_32S, false },
+    { "gotpcrel", RelocationType::R_X86_64_GOTPCREL, false },
+    { "dynrel", RelocationType::R_X86_64_PC32, true },
+    { "dynabs64", RelocationType::R_X86_64_64, true },
+    { "dynabs32", RelocationType::R_X86_64_32, true },
+} };
+
+} // namespace fle_tokenizer_detail
+
+struct SymbolToken {
+    std::string_view name;
+    size_t size;
+    size_t offset;
+};
+
+// Parse "name size offset"
+inline bool parse_symbol_line(std::string_view content, SymbolToken& out)
+{
+    using namespace fle_tokenizer_detail;
+    out.name = take_word(content);
+    return !out.name.empty() && parse_decimal(take_word(content), out.size)
+        && parse_decimal(take_word(content), out.offset);
+}
+
+struct RelocToken {
+    RelocationType type;
+    bool dynamic; // .dynrel / .dynabs64 / .dynabs32
+    std::string_view symbol;
+    int64_t addend;
+};
+
+/**
+ * Parse ".kind(symbol +/- addend)". The addend is hexadecimal, with an
+ * optional 0x prefix.
+ */
+inline bool parse_reloc_line(std::string_view content, RelocToken& out)
+{
+    using namespace fle_tokenizer_detail;
+    skip_blanks(content);
+    while (!content.empty() && is_blank(content.back())) {
+        content.remove_suffix(1);
+    }
+    if (content.size() < 2 || content[0] != '.' || content.back() != ')') {
+        return false;
+    }
+    content.remove_prefix(1);
+    content.remove_suffix(1);
+
+    size_t paren = content.find('(');
+    if (paren == std::string_view::npos) {
+        return false;
+    }
+    std::string_view keyword = content.substr(0, paren);
+    const RelocKeyword* kind = nullptr;
+    for (const auto& entry : RELOC_KEYWORDS) {
+        if (entry.name == keyword) {
+            kind = &entry;
+            break;
+        }
+    }
+    if (!kind) {
+        return false;
+    }
+    out.type = kind->type;
+    out.dynamic = kind->dynamic;
+    content.remove_prefix(paren + 1);
+
+    size_t n = 0;
+    while (n < content.size() && is_symbol_char(content[n])) {
+        ++n;
+    }
+    if (n == 0) {
+        return false;
+    }
+    out.symbol = content.substr(0, n);
+    content.remove_prefix(n);
+
+    skip_blanks(content);
+    if (content.empty() || (content[0] != '+' && content[0] != '-')) {
+        return false;
+    }
+    bool negative = content[0] == '-';
+    content.remove_prefix(1);
+    skip_blanks(content);
+
+    if (content.size() > 2 && content[0] == '0' && (content[1] == 'x' || content[1] == 'X')) {
+        content.remove_prefix(2);
+    }
+    uint64_t value = 0;
+    size_t digits = 0;
+    for (; digits < content.size(); ++digits) {
+        int v = hex_value(content[digits]);
+        if (v < 0) {
+            break;
+        }
+        if (value > (static_cast<uint64_t>(INT64_MAX) >> 4)) {
+            return false;
+        }
+        value = (value << 4) | static_cast<uint64_t>(v);
+    }
+    if (digits == 0) {
+        return false;
+    }
+    // Anything after the hex digits must still look like the old addend token ([0-9a-fA-FxX]*)
+    for (char c : content.substr(digits)) {
+        if (hex_value(c) < 0 && c != 'x' && c != 'X') {
+            return false;
+        }
+    }
+    out.addend = negative ? -static_cast<int64_t>(value) : static_cast<int64_t>(value);
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Hex decoding for 🔢 data lines (" 55 48 89 e5 ...").
+ *
+ * Runs of canonical " hh" triplets are decoded 16 or 32 bytes at a time
+ * with SIMD; anything else (other spacing, one-digit tokens, the short
+ * tail of a line) goes through the scalar tokenizer, which accepts the
+ * same input as `ss >> std::hex >> byte` did.
+ */
+
+enum class HexDecoder {
+    Scalar,
+    SSSE3, // 48 chars -> 16 bytes per step
+    AVX2, // 96 chars -> 32 bytes per step
+};
+
+// Most capable decoder supported by this CPU (checked once)
+HexDecoder best_hex_decoder();
+
+// Upper bound on the number of bytes `text` can decode to
+inline size_t hex_decoded_size_bound(std::string_view text) { return text.size() / 2 + 1; }
+
+/**
+ * Decode whitespace-separated hex bytes from `text` into `out`
+ * @param out Must have room for hex_decoded_size_bound(text) bytes
+ * @return Number of bytes written
+ */
+size_t decode_hex_bytes(std::string_view text, uint8_t* out);
+size_t decode_hex_bytes(std::string_view text, uint8_t* out, HexDecoder decoder);
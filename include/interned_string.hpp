@@ -0,0 +1,170 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+/**
+ * Process-wide string pool. Every distinct string is stored once and never
+ * freed, so the returned pointer is a stable identity for its contents.
+ * Each string also gets a dense index (the empty string is 0), so callers can
+ * keep per-name data in flat arrays of size() entries.
+ * Safe to call from several threads (ld loads inputs in parallel).
+ */
+class StringInterner {
+public:
+    struct Entry {
+        std::string text;
+        uint32_t index;
+    };
+
+    static const Entry* intern(std::string_view s)
+    {
+        if (s.empty()) {
+            return &empty();
+        }
+        size_t hash = std::hash<std::string_view> {}(s);
+        Shard& shard = shards()[hash % SHARD_COUNT];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(s);
+        if (it != shard.index.end()) {
+            return it->second;
+        }
+        const Entry* stored = &shard.entries.emplace_back(Entry { std::string(s), next_index().fetch_add(1) });
+        shard.index.emplace(stored->text, stored);
+        return stored;
+    }
+
+    static const Entry& empty()
+    {
+        static const Entry empty_entry { std::string(), 0 };
+        return empty_entry;
+    }
+
+    // Upper bound (exclusive) of every index handed out so far
+    static size_t size() { return next_index().load(); }
+
+private:
+    static constexpr size_t SHARD_COUNT = 64;
+
+    struct Shard {
+        std::mutex mutex;
+        std::deque<Entry> entries; // deque: stable addresses
+        std::unordered_map<std::string_view, const Entry*> index; // views into `entries`
+    };
+
+    static std::atomic<uint32_t>& next_index()
+    {
+        static std::atomic<uint32_t> next { 1 };
+        return next;
+    }
+
+    static std::array<Shard, SHARD_COUNT>& shards()
+    {
+        static std::array<Shard, SHARD_COUNT> instance;
+        return instance;
+    }
+};
+
+class InternedString;
+
+template <typename T>
+struct IsStringLike
+    : std::integral_constant<bool,
+          std::is_convertible<const T&, std::string_view>::value
+              && !std::is_same<std::decay_t<T>, InternedString>::value> { };
+
+/**
+ * Handle to an interned string.
+ *
+ * Equality and hashing compare the pool pointer, so they are O(1). Ordering
+ * compares contents, so std::map iteration order is the same as with
+ * std::string keys. Converts implicitly to const std::string&.
+ */
+class InternedString {
+public:
+    InternedString()
+        : ptr(&StringInterner::empty())
+    {
+    }
+    InternedString(std::string_view s)
+        : ptr(StringInterner::intern(s))
+    {
+    }
+    InternedString(const std::string& s)
+        : ptr(StringInterner::intern(s))
+    {
+    }
+    InternedString(const char* s)
+        : ptr(StringInterner::intern(s))
+    {
+    }
+
+    const std::string& str() const { return ptr->text; }
+    operator const std::string&() const { return ptr->text; }
+    std::string_view view() const { return ptr->text; }
+    const char* c_str() const { return ptr->text.c_str(); }
+    size_t size() const { return ptr->text.size(); }
+    size_t length() const { return ptr->text.size(); }
+    bool empty() const { return ptr->text.empty(); }
+
+    // Pool identity; equal strings have equal ids
+    uintptr_t id() const { return reinterpret_cast<uintptr_t>(ptr); }
+    // Dense number of this string, < StringInterner::size()
+    uint32_t index() const { return ptr->index; }
+
+    friend bool operator==(const InternedString& a, const InternedString& b) { return a.ptr == b.ptr; }
+    friend bool operator!=(const InternedString& a, const InternedString& b) { return a.ptr != b.ptr; }
+    friend bool operator<(const InternedString& a, const InternedString& b)
+    {
+        return a.ptr != b.ptr && a.ptr->text < b.ptr->text;
+    }
+
+    // Comparing with plain strings compares contents and does not intern
+    template <typename T, typename = std::enable_if_t<IsStringLike<T>::value>>
+    friend bool operator==(const InternedString& a, const T& b)
+    {
+        return a.view() == std::string_view(b);
+    }
+    template <typename T, typename = std::enable_if_t<IsStringLike<T>::value>>
+    friend bool operator==(const T& a, const InternedString& b)
+    {
+        return std::string_view(a) == b.view();
+    }
+    template <typename T, typename = std::enable_if_t<IsStringLike<T>::value>>
+    friend bool operator!=(const InternedString& a, const T& b)
+    {
+        return !(a == b);
+    }
+    template <typename T, typename = std::enable_if_t<IsStringLike<T>::value>>
+    friend bool operator!=(const T& a, const InternedString& b)
+    {
+        return !(a == b);
+    }
+
+    friend std::string operator+(const InternedString& a, const InternedString& b) { return a.str() + b.str(); }
+    friend std::string operator+(const InternedString& a, const std::string& b) { return a.str() + b; }
+    friend std::string operator+(const std::string& a, const InternedString& b) { return a + b.str(); }
+    friend std::string operator+(const InternedString& a, const char* b) { return a.str() + b; }
+    friend std::string operator+(const char* a, const InternedString& b) { return a + b.str(); }
+
+    friend std::ostream& operator<<(std::ostream& os, const InternedString& s) { return os << s.str(); }
+
+private:
+    const StringInterner::Entry* ptr;
+};
+
+namespace std {
+template <>
+struct hash<InternedString> {
+    size_t operator()(const InternedString& s) const noexcept { return std::hash<uintptr_t> {}(s.id()); }
+};
+}
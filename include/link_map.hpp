@@ -0,0 +1,70 @@
+#pragma once
+
+#include "fle.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * ld -Map=FILE 的链接映射 (见 src/student/ld_map.cpp)
+ *
+ * FLE_ld 在布局和符号决议完成后填好 LinkMap，write_link_map 把它写成文本：
+ * 各段、各输出节里每个输入节的来源 (目标文件或 "归档(成员)")、地址、大小和
+ * 其中定义的符号，被 --icf 折叠和 --gc-sections 丢掉的节，节排序的结果，
+ * 最后是按输入文件和按归档汇总的字节数 (从大到小)，用来找出谁占了输出的空间
+ */
+
+struct LinkMapSymbol {
+    std::string name;
+    uint64_t addr;
+    SymbolType type;
+};
+
+struct LinkMapInput {
+    std::string file;    // 目标文件名；归档成员为 "归档(成员)"
+    std::string archive; // 所在归档，普通目标文件为空
+    std::string section; // 输入节名；链接器生成的内容为 "<...>" 形式的说明
+    uint64_t addr = 0;
+    uint64_t size = 0;
+    uint64_t align = 1;
+    bool ordered = false; // 被 --symbol-ordering-file/--call-graph-profile 提前
+    std::vector<LinkMapSymbol> symbols; // 节内定义的符号，按地址排序
+};
+
+struct LinkMapOutput {
+    std::string name;
+    uint64_t addr = 0;
+    uint64_t size = 0;
+    uint64_t align = 1;
+    std::vector<LinkMapInput> inputs; // 按地址排列
+};
+
+// 不在输出中的输入节 (--icf 折叠、--gc-sections 丢弃)
+struct LinkMapDropped {
+    std::string file;
+    std::string section;
+    uint64_t size = 0;
+    std::string folded_into; // 折叠进的节 "文件:节"；被丢弃的节为空
+};
+
+struct LinkMap {
+    std::string output;
+    uint64_t entry = 0;
+    bool shared = false;
+    std::vector<ProgramHeader> segments;
+    std::vector<LinkMapOutput> sections;
+    std::vector<LinkMapDropped> folded;
+    std::vector<LinkMapDropped> discarded;
+    std::string ordering;        // 排序方式说明；未排序为空
+    size_t ordered_sections = 0;
+    size_t clusters = 0;         // --call-graph-profile 的簇数
+    bool has_crossings = false;  // 是否给出跨页调用估计
+    uint64_t crossings_before = 0;
+    uint64_t crossings_after = 0;
+};
+
+/**
+ * 把链接映射写到 path
+ * @throws std::runtime_error 无法写入文件时
+ */
+void write_link_map(const LinkMap& map, const std::string& path);
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "fle.hpp"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+ * ld --incremental 的链接状态 (见 src/student/ld_incremental.cpp, docs/incremental.md)
+ *
+ * 完整链接时记下输出布局：每个输入节在输出节中的位置和预留容量、全局符号
+ * 的决议结果、每条指向全局符号的重定位位置。状态写在输出文件旁
+ * (<output>.ldstate)。再次链接时，若变化的只是普通目标文件、它们的符号接口
+ * 不变、各节仍放得下，就只重拷这些节并就地重做相关重定位；否则完整链接。
+ * 只支持静态可执行文件 (没有 -shared、.fso 输入、--gc-sections、--icf、
+ * --symbol-ordering-file、--call-graph-profile 和 -Map)，也不合并可合并节中的重复字符串和常量
+ */
+
+// 输出节按布局顺序编号
+enum LinkOutputSection : uint32_t {
+    LINK_TEXT,
+    LINK_PLT,
+    LINK_RODATA,
+    LINK_DATA,
+    LINK_GOT,
+    LINK_BSS,
+    LINK_OUTPUT_SECTION_COUNT
+};
+constexpr const char* LINK_OUTPUT_SECTIONS[LINK_OUTPUT_SECTION_COUNT] = { ".text", ".plt", ".rodata", ".data", ".got", ".bss" };
+
+constexpr uint32_t LINK_STATE_NONE = UINT32_MAX;
+
+// 输入文件的指纹：大小和修改时间相同即视为未变，否则再比内容哈希
+struct LinkInputStamp {
+    std::string path;
+    uint64_t size = 0;
+    int64_t mtime_ns = 0;
+    uint64_t hash = 0;
+};
+
+struct LinkStateObject {
+    InternedString name;
+    uint32_t input; // 命令行输入下标；归档成员为 LINK_STATE_NONE
+    uint32_t section_first; // 本对象的输入节在 sections 中的区间
+    uint32_t section_count;
+    uint32_t local_first; // 本对象的局部符号在输出符号表中的区间
+    uint32_t local_count;
+    uint64_t defined_hash; // 定义的非局部符号 (名字, 类型)
+    uint64_t undefined_hash; // 引用的未定义符号名
+};
+
+struct LinkStateSection {
+    InternedString name;
+    uint32_t output; // LINK_OUTPUT_SECTIONS 下标
+    uint64_t out_off; // 在输出节中的偏移
+    uint64_t size; // 当前内容大小
+    uint64_t capacity; // 预留大小，之后的内容不能超过它
+};
+
+struct LinkStateSymbol {
+    InternedString name;
+    SymbolType type;
+    uint64_t addr;
+    uint32_t object; // 胜出的定义所在对象
+};
+
+// 一条目标为全局符号的重定位
+struct LinkStateSite {
+    uint32_t section; // 所在输入节 (sections 下标)
+    uint32_t symbol; // 目标 (globals 下标)
+    RelocationType type;
+    uint64_t out_off; // 在输出节中的偏移
+    int64_t addend;
+};
+
+struct LinkState {
+    bool relinkable = false; // 动态链接只记录这一项
+    std::string key; // 影响布局的选项，不同则完整链接
+    bool has_archives = false;
+    uint64_t section_vaddr[LINK_OUTPUT_SECTION_COUNT] = {};
+    LinkInputStamp output;
+    std::vector<LinkInputStamp> inputs;
+    std::vector<LinkStateObject> objects;
+    std::vector<LinkStateSection> sections;
+    std::vector<LinkStateSymbol> globals; // 按名字排序
+    std::vector<InternedString> got; // GOT 槽位顺序
+    std::vector<LinkStateSite> sites;
+};
+
+/* ld.cpp 中与增量链接共用的布局规则 */
+
+// 输入节名 → 输出节名；不参与链接的节返回 nullptr
+const char* output_section_for(const std::string& sec_name);
+
+// 输入节大小 (节头里的大小优先，.bss 没有数据)
+size_t get_section_size(const FLEObject& obj, const std::string& name, const FLESection& sec);
+
+// 输入节的对齐要求 (节头里的 align；.text 节至少为 --align-functions)
+size_t get_section_align(const FLEObject& obj, const std::string& name, const LinkerOptions& options);
+
+// 增量布局下输入节的预留大小，给以后的修改留出余量
+size_t incremental_capacity(size_t size);
+
+// 输出符号表里局部符号的名字
+std::string make_local_name(const std::string& obj, const std::string& name);
+
+// 全局符号在输出符号表中归属的节：按各输出节的地址区间判断
+const char* exported_section_for(uint64_t addr, const uint64_t (&section_vaddr)[LINK_OUTPUT_SECTION_COUNT]);
+
+// 对象的符号接口哈希，接口不变时符号决议和归档成员选取都不会变
+void link_interface_hashes(const FLEObject& obj, uint64_t& defined_hash, uint64_t& undefined_hash);
+
+// 影响布局的选项
+std::string link_state_key(const LinkerOptions& options);
+
+/**
+ * 尝试增量链接
+ * @param state 读入的状态，成功后已更新
+ * @param input_paths 解析后的输入路径，按命令行顺序
+ * @param output 成功时为更新后的输出
+ * @param reason 失败时说明为什么要完整链接
+ * @return 是否成功；失败时调用者应做完整链接 (FLE_ld 会重置 state)
+ */
+bool FLE_ld_relink(LinkState& state, const std::vector<std::string>& input_paths, const LinkerOptions& options,
+    FLEObject& output, std::string& reason);
+
+// 写出输出后调用：补全输入和输出的指纹，写 <output>.ldstate
+void save_link_state(LinkState& state, const std::vector<std::string>& input_paths, const LinkerOptions& options);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only private mapping of a whole file
+class MappedFile {
+public:
+    static std::shared_ptr<MappedFile> open(const std::string& filename)
+    {
+        int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw std::runtime_error("Cannot open " + filename + ": " + strerror(errno));
+        }
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            int err = errno;
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + filename + ": " + strerror(err));
+        }
+
+        auto file = std::shared_ptr<MappedFile>(new MappedFile());
+        file->length = static_cast<size_t>(st.st_size);
+        if (file->length > 0) {
+            file->addr = mmap(nullptr, file->length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (file->addr == MAP_FAILED) {
+                int err = errno;
+                ::close(fd);
+                throw std::runtime_error("Cannot map " + filename + ": " + strerror(err));
+            }
+        }
+        ::close(fd);
+        return file;
+    }
+
+    ~MappedFile()
+    {
+        if (addr != MAP_FAILED) {
+            munmap(addr, length);
+        }
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* data() const
+    {
+        return addr == MAP_FAILED ? nullptr : static_cast<const uint8_t*>(addr);
+    }
+    size_t size() const { return length; }
+    std::string_view text() const { return { reinterpret_cast<const char*>(data()), length }; }
+
+    // Hint that the mapping will be read front to back once (text formats)
+    void advise_sequential() const
+    {
+        if (addr != MAP_FAILED) {
+            madvise(addr, length, MADV_SEQUENTIAL);
+        }
+    }
+
+private:
+    MappedFile() = default;
+
+    void* addr = MAP_FAILED;
+    size_t length = 0;
+};
@@ -0,0 +1,128 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed-size worker pool for data-parallel loops.
+ *
+ * parallel_for() hands out indices dynamically and blocks until every index
+ * has run; the calling thread works too. If bodies throw, the exception of
+ * the lowest failing index is rethrown, so errors do not depend on timing.
+ * Not reentrant: do not call parallel_for() from inside a body.
+ */
+class ThreadPool {
+public:
+    // 0 = one thread per CPU
+    explicit ThreadPool(size_t threads = 0)
+    {
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        for (size_t i = 1; i < threads; ++i) {
+            workers.emplace_back([this] { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size() + 1; }
+
+    template <typename Body>
+    void parallel_for(size_t count, Body&& body)
+    {
+        if (workers.empty() || count <= 1) {
+            for (size_t i = 0; i < count; ++i) {
+                body(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> next { 0 };
+        size_t failed_index = count;
+        std::exception_ptr failure;
+        std::mutex failure_mutex;
+
+        std::function<void()> task = [&] {
+            for (size_t i; (i = next.fetch_add(1, std::memory_order_relaxed)) < count;) {
+                try {
+                    body(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(failure_mutex);
+                    if (i < failed_index) {
+                        failed_index = i;
+                        failure = std::current_exception();
+                    }
+                }
+            }
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &task;
+            pending = workers.size();
+            ++generation;
+        }
+        wake.notify_all();
+        task();
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            done.wait(lock, [this] { return pending == 0; });
+            job = nullptr;
+        }
+
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+private:
+    void worker_loop()
+    {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) {
+                return;
+            }
+            seen = generation;
+            std::function<void()>* task = job;
+            lock.unlock();
+            (*task)();
+            lock.lock();
+            if (--pending == 0) {
+                done.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    std::function<void()>* job = nullptr;
+    uint64_t generation = 0;
+    size_t pending = 0;
+    bool stopping = false;
+};
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+
+/*
+ * --time-trace[=FILE] / FLE_TIME_TRACE=FILE：各工具的分阶段计时 (见 src/base/time_trace.cpp)
+ *
+ * 记录的事件写成 Chrome trace_event JSON，可以直接在 Perfetto (ui.perfetto.dev) 或
+ * chrome://tracing 里打开。没有启用时计时点只检查一次全局开关，不取时间、不加锁
+ */
+
+extern bool time_trace_on;
+
+inline bool time_trace_enabled() { return time_trace_on; }
+
+/**
+ * 开始记录；必须在启动任何工作线程之前调用
+ * @param path 输出文件；是目录时写到其中的 <process>-<pid>.json
+ * @param process 在时间线上显示的进程名 (工具名)
+ */
+void time_trace_start(const std::string& path, const std::string& process);
+
+/**
+ * 把已记录的事件写到 time_trace_start 指定的文件；未启用时什么也不做
+ * @throws std::runtime_error 无法写入文件时
+ */
+void time_trace_write();
+
+// 记录从 start 到现在的一段 (用于已经在量时间的连续阶段，如 FLE_ld 的各遍)
+void time_trace_complete(const char* name, std::chrono::steady_clock::time_point start, const std::string& detail = {});
+
+// 记录一个瞬时事件 (例如 exec 跳到入口、不再返回)
+void time_trace_instant(const char* name, const std::string& detail = {});
+
+// 作用域计时：构造时开始，析构时记录一段
+class TimeTraceScope {
+public:
+    explicit TimeTraceScope(const char* name, const std::string& detail = {})
+        : name(name)
+    {
+        if (time_trace_enabled()) {
+            this->detail = detail;
+            start = std::chrono::steady_clock::now();
+        }
+    }
+    ~TimeTraceScope()
+    {
+        if (time_trace_enabled()) {
+            time_trace_complete(name, start, detail);
+        }
+    }
+    TimeTraceScope(const TimeTraceScope&) = delete;
+    TimeTraceScope& operator=(const TimeTraceScope&) = delete;
+
+private:
+    const char* name;
+    std::string detail;
+    std::chrono::steady_clock::time_point start;
+};
@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <array>
 #include <cstdio>
+#include "time_trace.hpp"
 #include <fmt/format.h>
 #include <memory>
 #include <stdexcept>
@@ -12,6 +13,7 @@
 // 执行系统命令并返回输出结果
 inline std::string execute_command(std::string_view cmd)
 {
+    TimeTraceScope trace("execute_command", std::string(cmd));
     auto command_with_stderr = fmt::format("LANG=C {} 2>/dev/null", cmd);
 
     std::unique_ptr<FILE, decltype(&pclose)> pipe(
@@ -0,0 +1,444 @@
+#include "fle.hpp"
+#include "mapped_file.hpp"
+#include <cstring>
+#include <stdexcept>
+#include <unordered_map>
+
+/*
+ * Binary FLE container
+ *
+ * All integers are little-endian. Every table starts on an 8-byte boundary
+ * and every section payload starts on a page boundary, so a mapped file can
+ * be used in place:
+ *
+ *   BinHeader
+ *   section table    BinSection[sections.count]
+ *   relocation array BinReloc[relocs.count]    (sliced by BinSection)
+ *   symbol table     BinSymbol[symbols.count]
+ *   program headers  BinPhdr[phdrs.count]
+ *   section headers  BinShdr[shdrs.count]
+ *   needed libraries BinStr[needed.count]
+ *   dynamic relocs   BinReloc[dyn_relocs.count]
+ *   member table     BinMember[members.count]  (archives only)
+ *   string table     char[strtab.count]
+ *   section payloads (page aligned)
+ *   member images    (page aligned, each a complete container)
+ */
+
+namespace {
+
+constexpr char BIN_MAGIC[8] = { '\x7f', 'F', 'L', 'E', 'B', 'I', 'N', '\0' };
+constexpr uint32_t BIN_VERSION = 3; // 2: BinShdr.entsize, 3: BinShdr.align
+constexpr uint64_t BIN_PAGE_SIZE = 4096;
+
+struct BinStr {
+    uint32_t offset; // Offset into the string table
+    uint32_t length;
+};
+
+struct BinTable {
+    uint64_t offset; // File offset of the first entry
+    uint64_t count; // Number of entries (bytes for the string table)
+};
+
+struct BinHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t header_size;
+    BinStr type;
+    BinStr name;
+    uint64_t entry;
+    uint64_t image_size;
+    BinTable sections;
+    BinTable relocs;
+    BinTable symbols;
+    BinTable phdrs;
+    BinTable shdrs;
+    BinTable needed;
+    BinTable dyn_relocs;
+    BinTable members;
+    BinTable strtab;
+};
+
+struct BinSection {
+    BinStr name;
+    uint32_t has_symbols;
+    uint32_t reserved;
+    uint64_t data_offset;
+    uint64_t data_size;
+    uint64_t reloc_first;
+    uint64_t reloc_count;
+};
+
+struct BinReloc {
+    BinStr symbol;
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+    int64_t addend;
+};
+
+struct BinSymbol {
+    BinStr name;
+    BinStr section;
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+struct BinPhdr {
+    BinStr name;
+    uint32_t flags;
+    uint32_t reserved;
+    uint64_t vaddr;
+    uint64_t size;
+};
+
+struct BinShdr {
+    BinStr name;
+    uint32_t type;
+    uint32_t flags;
+    uint64_t addr;
+    uint64_t offset;
+    uint64_t size;
+    uint64_t entsize;
+    uint64_t align;
+};
+
+struct BinMember {
+    uint64_t offset;
+    uint64_t size;
+};
+
+uint64_t align_to(uint64_t value, uint64_t align)
+{
+    return (value + align - 1) / align * align;
+}
+
+// ======================= Writer =======================
+
+class BinaryImage {
+public:
+    explicit BinaryImage(const FLEObject& obj)
+    {
+        build(obj);
+    }
+
+    const std::vector<uint8_t>& bytes() const { return image; }
+
+private:
+    std::vector<uint8_t> image;
+    std::string strtab;
+    std::unordered_map<std::string, uint32_t> str_index;
+
+    BinStr intern(const std::string& s)
+    {
+        auto [it, inserted] = str_index.try_emplace(s, static_cast<uint32_t>(strtab.size()));
+        if (inserted) {
+            strtab += s;
+        }
+        return { it->second, static_cast<uint32_t>(s.size()) };
+    }
+
+    template <typename T>
+    static BinTable place(uint64_t& cursor, size_t count)
+    {
+        BinTable table { align_to(cursor, 8), count };
+        cursor = table.offset + count * sizeof(T);
+        return table;
+    }
+
+    template <typename T>
+    void put(uint64_t offset, const T& value)
+    {
+        std::memcpy(image.data() + offset, &value, sizeof(T));
+    }
+
+    void build(const FLEObject& obj)
+    {
+        std::vector<BinSection> sections;
+        std::vector<BinReloc> relocs;
+        std::vector<BinSymbol> symbols;
+        std::vector<BinPhdr> phdrs;
+        std::vector<BinShdr> shdrs;
+        std::vector<BinStr> needed;
+        std::vector<BinReloc> dyn_relocs;
+
+        auto make_reloc = [&](const Relocation& reloc) {
+            return BinReloc { intern(reloc.symbol), static_cast<uint32_t>(reloc.type), 0,
+                reloc.offset, reloc.addend };
+        };
+
+        for (const auto& [name, sec] : obj.sections) {
+            sections.push_back({ intern(name), sec.has_symbols ? 1u : 0u, 0, 0, sec.data.size(),
+                relocs.size(), sec.relocs.size() });
+            for (const auto& reloc : sec.relocs) {
+                relocs.push_back(make_reloc(reloc));
+            }
+        }
+        for (const auto& sym : obj.symbols) {
+            symbols.push_back({ intern(sym.name), intern(sym.section), static_cast<uint32_t>(sym.type), 0,
+                sym.offset, sym.size });
+        }
+        for (const auto& phdr : obj.phdrs) {
+            phdrs.push_back({ intern(phdr.name), phdr.flags, 0, phdr.vaddr, phdr.size });
+        }
+        for (const auto& shdr : obj.shdrs) {
+            shdrs.push_back({ intern(shdr.name), shdr.type, shdr.flags, shdr.addr, shdr.offset, shdr.size, shdr.entsize, shdr.align });
+        }
+        for (const auto& lib : obj.needed) {
+            needed.push_back(intern(lib));
+        }
+        for (const auto& reloc : obj.dyn_relocs) {
+            dyn_relocs.push_back(make_reloc(reloc));
+        }
+
+        BinHeader header {};
+        std::memcpy(header.magic, BIN_MAGIC, sizeof(BIN_MAGIC));
+        header.version = BIN_VERSION;
+        header.header_size = sizeof(BinHeader);
+        header.type = intern(obj.type);
+        header.name = intern(obj.name);
+        header.entry = obj.entry;
+
+        uint64_t cursor = sizeof(BinHeader);
+        header.sections = place<BinSection>(cursor, sections.size());
+        header.relocs = place<BinReloc>(cursor, relocs.size());
+        header.symbols = place<BinSymbol>(cursor, symbols.size());
+        header.phdrs = place<BinPhdr>(cursor, phdrs.size());
+        header.shdrs = place<BinShdr>(cursor, shdrs.size());
+        header.needed = place<BinStr>(cursor, needed.size());
+        header.dyn_relocs = place<BinReloc>(cursor, dyn_relocs.size());
+        header.members = place<BinMember>(cursor, obj.members.size());
+        header.strtab = place<char>(cursor, strtab.size());
+
+        // Page-align every payload so the loader can hand out pointers into the mapping
+        for (auto& sec : sections) {
+            if (sec.data_size == 0) {
+                continue;
+            }
+            sec.data_offset = align_to(cursor, BIN_PAGE_SIZE);
+            cursor = sec.data_offset + sec.data_size;
+        }
+
+        std::vector<BinaryImage> member_images;
+        std::vector<BinMember> members;
+        for (const auto& member : obj.members) {
+            if (member.lazy_source) {
+                FLEObject full = member;
+                materialize_member(full);
+                member_images.emplace_back(full);
+            } else {
+                member_images.emplace_back(member);
+            }
+            uint64_t offset = align_to(cursor, BIN_PAGE_SIZE);
+            members.push_back({ offset, member_images.back().bytes().size() });
+            cursor = offset + members.back().size;
+        }
+        header.image_size = cursor;
+
+        image.assign(cursor, 0);
+        put(0, header);
+        auto put_table = [&](const BinTable& table, const auto& entries) {
+            if (!entries.empty()) {
+                std::memcpy(image.data() + table.offset, entries.data(), entries.size() * sizeof(entries[0]));
+            }
+        };
+        put_table(header.sections, sections);
+        put_table(header.relocs, relocs);
+        put_table(header.symbols, symbols);
+        put_table(header.phdrs, phdrs);
+        put_table(header.shdrs, shdrs);
+        put_table(header.needed, needed);
+        put_table(header.dyn_relocs, dyn_relocs);
+        put_table(header.members, members);
+        put_table(header.strtab, strtab);
+
+        size_t i = 0;
+        for (const auto& [name, sec] : obj.sections) {
+            if (!sec.data.empty()) {
+                std::memcpy(image.data() + sections[i].data_offset, sec.data.data(), sec.data.size());
+            }
+            ++i;
+        }
+        for (size_t m = 0; m < members.size(); ++m) {
+            const auto& bytes = member_images[m].bytes();
+            std::memcpy(image.data() + members[m].offset, bytes.data(), bytes.size());
+        }
+    }
+};
+
+// ======================= Reader =======================
+
+class BinaryReader {
+public:
+    BinaryReader(const uint8_t* base, size_t size, std::shared_ptr<const void> owner)
+        : base(base)
+        , size(size)
+        , owner(std::move(owner))
+    {
+    }
+
+    FLEObject read()
+    {
+        if (size < sizeof(BinHeader)) {
+            corrupt("truncated header");
+        }
+        std::memcpy(&header, base, sizeof(BinHeader));
+        if (std::memcmp(header.magic, BIN_MAGIC, sizeof(BIN_MAGIC)) != 0) {
+            corrupt("bad magic");
+        }
+        if (header.version != BIN_VERSION) {
+            corrupt("unsupported version " + std::to_string(header.version));
+        }
+        check_range(header.strtab.offset, header.strtab.count);
+        strtab = reinterpret_cast<const char*>(base + header.strtab.offset);
+
+        FLEObject obj;
+        obj.type = str(header.type);
+        obj.name = str(header.name);
+        obj.entry = header.entry;
+
+        const auto* relocs = table<BinReloc>(header.relocs);
+        for (const auto& bsec : span(table<BinSection>(header.sections), header.sections.count)) {
+            FLESection sec;
+            sec.name = str(bsec.name);
+            sec.has_symbols = bsec.has_symbols != 0;
+            if (bsec.data_size > 0) {
+                check_range(bsec.data_offset, bsec.data_size);
+                sec.data = SectionData::borrow(base + bsec.data_offset, bsec.data_size, owner);
+            }
+            if (bsec.reloc_first + bsec.reloc_count > header.relocs.count) {
+                corrupt("relocation slice out of range");
+            }
+            sec.relocs.reserve(bsec.reloc_count);
+            for (uint64_t r = 0; r < bsec.reloc_count; ++r) {
+                sec.relocs.push_back(reloc(relocs[bsec.reloc_first + r]));
+            }
+            obj.sections.emplace(sec.name, std::move(sec));
+        }
+
+        for (const auto& bsym : span(table<BinSymbol>(header.symbols), header.symbols.count)) {
+            obj.symbols.push_back(symbol(bsym));
+        }
+        for (const auto& bphdr : span(table<BinPhdr>(header.phdrs), header.phdrs.count)) {
+            obj.phdrs.push_back({ str(bphdr.name), bphdr.vaddr, bphdr.size, bphdr.flags });
+        }
+        for (const auto& bshdr : span(table<BinShdr>(header.shdrs), header.shdrs.count)) {
+            obj.shdrs.push_back({ str(bshdr.name), bshdr.type, bshdr.flags, bshdr.addr, bshdr.offset,
+                bshdr.size, bshdr.entsize, bshdr.align });
+        }
+        for (const auto& lib : span(table<BinStr>(header.needed), header.needed.count)) {
+            obj.needed.push_back(str(lib));
+        }
+        for (const auto& breloc : span(table<BinReloc>(header.dyn_relocs), header.dyn_relocs.count)) {
+            obj.dyn_relocs.push_back(reloc(breloc));
+        }
+        for (const auto& member : span(table<BinMember>(header.members), header.members.count)) {
+            check_range(member.offset, member.size);
+            BinaryReader nested(base + member.offset, member.size, owner);
+            obj.members.push_back(nested.read());
+        }
+        return obj;
+    }
+
+private:
+    const uint8_t* base;
+    size_t size;
+    std::shared_ptr<const void> owner;
+    BinHeader header {};
+    const char* strtab = nullptr;
+
+    template <typename T>
+    struct Span {
+        const T* first;
+        uint64_t count;
+        const T* begin() const { return first; }
+        const T* end() const { return first + count; }
+    };
+
+    template <typename T>
+    static Span<T> span(const T* first, uint64_t count)
+    {
+        return { first, count };
+    }
+
+    [[noreturn]] static void corrupt(const std::string& what)
+    {
+        throw std::runtime_error("Corrupt binary FLE: " + what);
+    }
+
+    void check_range(uint64_t offset, uint64_t length) const
+    {
+        if (offset > size || length > size - offset) {
+            corrupt("range out of bounds");
+        }
+    }
+
+    template <typename T>
+    const T* table(const BinTable& t) const
+    {
+        if (t.count > size / sizeof(T)) {
+            corrupt("table too large");
+        }
+        check_range(t.offset, t.count * sizeof(T));
+        if (t.offset % alignof(T) != 0) {
+            corrupt("misaligned table");
+        }
+        return reinterpret_cast<const T*>(base + t.offset);
+    }
+
+    std::string str(const BinStr& s) const
+    {
+        if (static_cast<uint64_t>(s.offset) + s.length > header.strtab.count) {
+            corrupt("string out of range");
+        }
+        return std::string(strtab + s.offset, s.length);
+    }
+
+    Symbol symbol(const BinSymbol& s) const
+    {
+        if (s.type > static_cast<uint32_t>(SymbolType::UNDEFINED)) {
+            corrupt("bad symbol type");
+        }
+        return { static_cast<SymbolType>(s.type), str(s.section), s.offset, s.size, str(s.name) };
+    }
+
+    Relocation reloc(const BinReloc& r) const
+    {
+        if (r.type > static_cast<uint32_t>(RelocationType::R_X86_64_GOTPCREL)) {
+            corrupt("bad relocation type");
+        }
+        return { static_cast<RelocationType>(r.type), r.offset, str(r.symbol), r.addend };
+    }
+};
+
+} // namespace
+
+bool is_binary_fle(const std::string& filename)
+{
+    std::ifstream in(filename, std::ios::binary);
+    char magic[sizeof(BIN_MAGIC)] = {};
+    in.read(magic, sizeof(magic));
+    return in.gcount() == sizeof(magic) && std::memcmp(magic, BIN_MAGIC, sizeof(magic)) == 0;
+}
+
+FLEObject load_fle_binary(const std::string& filename)
+{
+    auto mapping = MappedFile::open(filename);
+    BinaryReader reader(mapping->data(), mapping->size(), mapping);
+    FLEObject obj = reader.read();
+    obj.name = std::filesystem::path(filename).filename().string(); // Same naming rule as the JSON loader
+    return obj;
+}
+
+void FLE_write_binary(const FLEObject& obj, const std::string& filename)
+{
+    BinaryImage image(obj);
+    std::ofstream out(filename, std::ios::binary | std::ios::trunc);
+    if (!out) {
+        throw std::runtime_error("Cannot write " + filename);
+    }
+    out.write(reinterpret_cast<const char*>(image.bytes().data()), image.bytes().size());
+}
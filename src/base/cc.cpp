@@ -1,11 +1,14 @@
 #define FMT_HEADER_ONLY
 #include "fle.hpp"
 #include "string_utils.hpp"
+#include "time_trace.hpp"
 #include "utils.hpp"
 #include <algorithm>
 #include <cstddef>
 #include <filesystem>
 #include <fmt/format.h>
+#include <fstream>
+#include <map>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -55,29 +58,26 @@ constexpr auto RELOCATION_FORMATS = std::array {
     std::pair { "R_X86_64_REX_GOTPCRELX"sv, RelocationFormat { ".gotpcrel"sv, 4 } }
 };
 
-// 解析符号表
-std::vector<Symbol> parse_symbols(const std::string& binary, std::string_view section)
+// 解析符号表，按所在节分组并按偏移排序
+std::map<std::string, std::vector<Symbol>> parse_symbols(const std::string& symbol_dump)
 {
     static const std::regex symbol_pattern {
         R"(^([0-9a-fA-F]+)\s+(l|g|w)\s+(\w+)?\s+([.a-zA-Z0-9_]+)\s+([0-9a-fA-F]+)\s+(.*)$)"
     };
 
-    std::vector<Symbol> symbols;
-    const auto symbol_dump = execute_command(fmt::format("objdump -t {}", binary));
-
+    std::map<std::string, std::vector<Symbol>> symbols;
     for (const auto& line : splitlines(symbol_dump)) {
         if (std::smatch match; std::regex_match(line, match, symbol_pattern)) {
-            auto sym = Symbol::from_regex_match(match, section);
-            if (match[4].str() != section) {
-                continue;
-            }
-            symbols.push_back(sym);
+            const std::string section = match[4].str();
+            symbols[section].push_back(Symbol::from_regex_match(match, section));
         }
     }
 
-    std::sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) {
-        return a.offset < b.offset;
-    });
+    for (auto& [_, syms] : symbols) {
+        std::sort(syms.begin(), syms.end(), [](const Symbol& a, const Symbol& b) {
+            return a.offset < b.offset;
+        });
+    }
 
     return symbols;
 }
@@ -97,25 +97,24 @@ std::string format_symbol_line(const Symbol& sym)
     }
 }
 
-// 解析重定位信息
-std::map<int, std::pair<int, std::string>> parse_relocations(
-    const std::string& binary, std::string_view section)
+// 解析重定位信息，按被重定位的节分组
+std::map<std::string, std::map<int, std::pair<int, std::string>>> parse_relocations(const std::string& reloc_dump)
 {
     static const std::regex reloc_pattern {
         R"(^\s*([0-9a-fA-F]+)\s+([0-9a-fA-F]+)\s+(\S+)\s+([0-9a-fA-F]+)\s+(.*)$)"
     };
+    static const std::regex header_pattern { R"(^Relocation section '\.rela(\S+)'.*$)" };
 
-    std::map<int, std::pair<int, std::string>> relocations;
-    const auto reloc_dump = execute_command(fmt::format("readelf -rW {}", binary));
-    bool in_section = false;
+    std::map<std::string, std::map<int, std::pair<int, std::string>>> relocations;
+    std::map<int, std::pair<int, std::string>>* current = nullptr;
 
     for (const auto& line : splitlines(reloc_dump)) {
-        if (str_contains(line, "Relocation section")) {
-            in_section = str_contains(line, fmt::format("'.rela{}'", section));
+        if (std::smatch match; std::regex_match(line, match, header_pattern)) {
+            current = &relocations[match[1].str()];
             continue;
         }
 
-        if (!in_section)
+        if (!current)
             continue;
 
         if (std::smatch match; std::regex_match(line, match, reloc_pattern)) {
@@ -135,7 +134,7 @@ std::map<int, std::pair<int, std::string>> parse_relocations(
             }
 
             const auto& [_, format] = *format_it;
-            relocations.emplace(offset,
+            current->emplace(offset,
                 std::pair { static_cast<int>(format.size),
                     fmt::format("{}({})", format.format, symbol) });
         }
@@ -143,11 +142,11 @@ std::map<int, std::pair<int, std::string>> parse_relocations(
     return relocations;
 }
 
-std::vector<std::string> elf_to_fle(
-    const std::string& binary, std::string_view section, bool is_bss = false)
+std::vector<std::string> elf_to_fle(const std::vector<Symbol>& symbols,
+    const std::map<int, std::pair<int, std::string>>& relocations,
+    std::string_view section_data, bool is_bss = false)
 {
     std::vector<std::string> result;
-    const auto symbols = parse_symbols(binary, section);
 
     // BSS段只需处理符号
     if (is_bss) {
@@ -157,11 +156,6 @@ std::vector<std::string> elf_to_fle(
         return result;
     }
 
-    // 获取节数据和重定位信息
-    const auto section_data = execute_command(
-        fmt::format("objcopy --dump-section {}=/dev/stdout {}", section, binary));
-    const auto relocations = parse_relocations(binary, section);
-
     // 处理数据
     int skip = 0;
     std::vector<uint8_t> holding;
@@ -221,6 +215,8 @@ constexpr auto COMPILER_FLAGS = std::array {
     "-nostdlib"sv,
     "-ffreestanding"sv,
     "-fno-asynchronous-unwind-tables"sv,
+    "-ffunction-sections"sv, // 每个函数、数据对象单独成节 (.text.foo)，供 ld --gc-sections 按节丢弃
+    "-fdata-sections"sv,
 };
 
 void FLE_cc(const std::vector<std::string>& options)
@@ -253,8 +249,12 @@ void FLE_cc(const std::vector<std::string>& options)
 
     // std::cerr << "running: " << join(gcc_cmd, " ") << "\n";
 
-    if (std::system(join(gcc_cmd, " ").c_str()) != 0) {
-        throw std::runtime_error("gcc compilation failed");
+    {
+        const auto command = join(gcc_cmd, " ");
+        TimeTraceScope trace("gcc", command);
+        if (std::system(command.c_str()) != 0) {
+            throw std::runtime_error("gcc compilation failed");
+        }
     }
 
     // 解析目标文件
@@ -264,12 +264,18 @@ void FLE_cc(const std::vector<std::string>& options)
 
     // 处理每个节
     static const std::regex section_pattern {
-        R"(^\s*([0-9]+)\s+(\.(\w|\.)+)\s+([0-9a-fA-F]+)\s+.*$)"
+        R"(^\s*([0-9]+)\s+(\.(\w|\.)+)\s+([0-9a-fA-F]+)\s+[0-9a-fA-F]+\s+[0-9a-fA-F]+\s+([0-9a-fA-F]+)\s+2\*\*([0-9]+)\s*$)"
     };
 
     auto lines = splitlines(objdump_output);
     std::vector<SectionHeader> section_headers;
-    std::vector<std::pair<std::string, bool>> sections_to_process;
+    struct SectionToProcess {
+        std::string name;
+        bool is_nobits;
+        size_t file_offset;
+        size_t size;
+    };
+    std::vector<SectionToProcess> sections_to_process;
     size_t current_offset = 0;
 
     // 第一遍扫描:收集节头信息
@@ -321,23 +327,72 @@ void FLE_cc(const std::vector<std::string>& options)
             .addr = 0,
             .offset = current_offset,
             .size = size,
+            .align = uint64_t { 1 } << std::stoul(match[6].str()), // Algn 列是 2**n
         });
 
         current_offset += size;
-        sections_to_process.emplace_back(section_name, is_nobits);
+        sections_to_process.push_back({ section_name, is_nobits, std::stoul(match[5].str(), nullptr, 16), size });
+    }
+
+    // objdump -h 不显示可合并属性：从 readelf -SW 取 ES 列和 M/S 标志
+    static const std::regex elf_section_pattern {
+        R"(^\s*\[\s*[0-9]+\]\s+(\S+)\s+\S+\s+[0-9a-fA-F]+\s+[0-9a-fA-F]+\s+[0-9a-fA-F]+\s+([0-9a-fA-F]+)\s+([A-Za-z]*)\s+[0-9]+\s+[0-9]+\s+[0-9]+$)"
+    };
+    for (const auto& line : splitlines(execute_command(fmt::format("readelf -SW {}", binary)))) {
+        std::smatch match;
+        if (!std::regex_match(line, match, elf_section_pattern) || !str_contains(match[3].str(), "M")) {
+            continue;
+        }
+        const auto header = std::find_if(section_headers.begin(), section_headers.end(),
+            [&](const SectionHeader& shdr) { return shdr.name == match[1].str(); });
+        const uint64_t entsize = std::stoull(match[2].str(), nullptr, 16);
+        if (header == section_headers.end() || entsize == 0) {
+            continue;
+        }
+        header->flags |= SHF::MERGE;
+        if (str_contains(match[3].str(), "S")) {
+            header->flags |= SHF::STRINGS;
+        }
+        header->entsize = entsize;
     }
 
     // 先写入所有节头
     writer.write_section_headers(section_headers);
 
     // 第二遍:写入节数据
-    for (const auto& [section_name, is_nobits] : sections_to_process) {
-        writer.begin_section(section_name);
-        for (const auto& line : elf_to_fle(binary, section_name, is_nobits)) {
+    // 符号表和重定位只解析一次；节数据按节头里的文件偏移直接从目标文件读，
+    // 不再每个节调用一次 objdump/objcopy/readelf (-ffunction-sections 后节很多)
+    const auto symbols = parse_symbols(execute_command(fmt::format("objdump -t {}", binary)));
+    const auto relocations = parse_relocations(execute_command(fmt::format("readelf -rW {}", binary)));
+    std::ifstream object_file(binary, std::ios::binary);
+    if (!object_file) {
+        throw std::runtime_error(fmt::format("cannot open {}", binary));
+    }
+
+    const decltype(symbols)::mapped_type no_symbols;
+    const decltype(relocations)::mapped_type no_relocations;
+    for (const auto& section : sections_to_process) {
+        const auto sym_it = symbols.find(section.name);
+        const auto reloc_it = relocations.find(section.name);
+
+        std::string section_data;
+        if (!section.is_nobits) {
+            section_data.resize(section.size);
+            object_file.seekg(static_cast<std::streamoff>(section.file_offset));
+            if (!object_file.read(section_data.data(), static_cast<std::streamsize>(section.size))) {
+                throw std::runtime_error(fmt::format("cannot read section {} from {}", section.name, binary));
+            }
+        }
+
+        writer.begin_section(section.name);
+        for (const auto& line : elf_to_fle(sym_it != symbols.end() ? sym_it->second : no_symbols,
+                 reloc_it != relocations.end() ? reloc_it->second : no_relocations,
+                 section_data, section.is_nobits)) {
             writer.write_line(line);
         }
         writer.end_section();
     }
+    object_file.close();
 
     // 写入输出文件
     const std::filesystem::path input_path { binary };
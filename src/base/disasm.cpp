@@ -43,7 +43,7 @@ bool is_code_section(const std::string& section_name)
 }
 
 // 辅助函数：格式化数据字节
-std::string format_data_bytes(const std::vector<uint8_t>& data, size_t offset, size_t max_len = 16)
+std::string format_data_bytes(const SectionData& data, size_t offset, size_t max_len = 16)
 {
     std::stringstream ss;
     for (size_t i = 0; i < max_len && offset + i < data.size(); ++i) {
@@ -55,7 +55,7 @@ std::string format_data_bytes(const std::vector<uint8_t>& data, size_t offset, s
 }
 
 // 辅助函数：获取字符串实际长度
-size_t get_string_length(const std::vector<uint8_t>& data, size_t offset)
+size_t get_string_length(const SectionData& data, size_t offset)
 {
     size_t len = 0;
     while (offset + len < data.size() && data[offset + len] != 0) {
@@ -65,7 +65,7 @@ size_t get_string_length(const std::vector<uint8_t>& data, size_t offset)
 }
 
 // 辅助函数：格式化字符串内容为注释
-std::string format_string_comment(const std::vector<uint8_t>& data, size_t offset, size_t len)
+std::string format_string_comment(const SectionData& data, size_t offset, size_t len)
 {
     std::stringstream ss;
     ss << "# \"";
@@ -1,6 +1,10 @@
 #include "fle.hpp"
+#include "reloc_engine.hpp"
 #include "string_utils.hpp"
+#include "time_trace.hpp"
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <cstdint>
 #include <cstring>
 #include <iostream>
@@ -8,6 +12,7 @@
 #include <stdexcept>
 #include <sys/mman.h>
 #include <unistd.h>
+#include <unordered_map>
 #include <unordered_set>
 #include <vector>
 
@@ -17,7 +22,7 @@ struct LoadedModule {
     std::string name;
     FLEObject obj;
     uint64_t load_base;
-    std::map<std::string, uint64_t> section_addrs;
+    std::unordered_map<InternedString, uint64_t> section_addrs;
 };
 
 // Global list of loaded modules to maintain loading order
@@ -29,6 +34,9 @@ std::unordered_set<std::string> loaded_module_names;
 bool need_low_address = false;
 std::unordered_set<std::string> scanned_names;
 
+// 全局符号表：按模块加载顺序，第一个定义者生效
+std::unordered_map<InternedString, uint64_t> global_symbols;
+
 // Helper to load FLE from file (searches FLE_LIBRARY_PATH)
 FLEObject load_fle_with_path(const std::string& filename)
 {
@@ -110,21 +118,72 @@ void scan_dependencies_recursive(const std::string& filename)
     }
 }
 
-// Helper to resolve a symbol across all loaded modules
-uint64_t resolve_symbol(const std::string& name)
+// Index the GLOBAL/WEAK symbols of all loaded modules, in load order
+void build_global_symbols()
 {
+    global_symbols.clear();
     for (const auto& mod : loaded_modules) {
         for (const auto& sym : mod.obj.symbols) {
-            // We search for GLOBAL or WEAK symbols that are defined (not UNDEFINED)
-            if (sym.name == name && (sym.type == SymbolType::GLOBAL || sym.type == SymbolType::WEAK)) {
-                auto it = mod.section_addrs.find(sym.section);
-                if (it != mod.section_addrs.end()) {
-                    return it->second + sym.offset;
-                }
+            if (sym.type != SymbolType::GLOBAL && sym.type != SymbolType::WEAK) {
+                continue;
+            }
+            auto it = mod.section_addrs.find(sym.section);
+            if (it != mod.section_addrs.end()) {
+                global_symbols.try_emplace(sym.name, it->second + sym.offset);
+            }
+        }
+    }
+}
+
+// Map a module's segments at load_base (RW until relocation is done) and copy
+// their sections in. A segment holds every section whose header address lies
+// inside it; files without section headers have one segment per section,
+// named after that section.
+void map_segments(const FLEObject& obj, uint64_t load_base, std::unordered_map<InternedString, uint64_t>& section_addrs)
+{
+    for (const auto& phdr : obj.phdrs) {
+        if (phdr.size == 0)
+            continue;
+
+        void* target_addr = (void*)(load_base + phdr.vaddr);
+        void* map_res = mmap(target_addr, phdr.size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS, -1, 0);
+        if (map_res == MAP_FAILED) {
+            throw std::runtime_error("Failed to map segment " + phdr.name + ": " + strerror(errno));
+        }
+
+        std::vector<std::pair<std::string, uint64_t>> contents; // (section, vaddr)
+        if (obj.shdrs.empty()) {
+            contents.push_back({ phdr.name, phdr.vaddr });
+        }
+        for (const auto& shdr : obj.shdrs) {
+            if (shdr.addr >= phdr.vaddr && shdr.addr + shdr.size <= phdr.vaddr + phdr.size) {
+                contents.push_back({ shdr.name, shdr.addr });
             }
         }
+
+        for (const auto& [name, vaddr] : contents) {
+            auto it = obj.sections.find(name);
+            if (it == obj.sections.end()) {
+                throw std::runtime_error("Section data not found for segment: " + phdr.name);
+            }
+            // .bss has no data; the anonymous mapping is already zero
+            if (name != ".bss" && !starts_with(name, ".bss.")) {
+                size_t len = std::min<uint64_t>(it->second.data.size(), phdr.vaddr + phdr.size - vaddr);
+                memcpy((void*)(load_base + vaddr), it->second.data.data(), len);
+            }
+            section_addrs[name] = load_base + vaddr;
+        }
+    }
+}
+
+// Helper to resolve a symbol across all loaded modules
+uint64_t resolve_symbol(const InternedString& name)
+{
+    auto it = global_symbols.find(name);
+    if (it == global_symbols.end()) {
+        throw std::runtime_error("Symbol not found: " + name);
     }
-    throw std::runtime_error("Symbol not found: " + name);
+    return it->second;
 }
 
 void load_module_recursive(const std::string& filename)
@@ -258,39 +317,7 @@ void load_module_recursive(const std::string& filename)
         }
     }
 
-    // Map segments
-    for (const auto& phdr : obj.phdrs) {
-        if (phdr.size == 0)
-            continue;
-
-        void* target_addr = (void*)(mod.load_base + phdr.vaddr);
-        void* map_res = mmap(target_addr, phdr.size,
-            PROT_READ | PROT_WRITE, // Always RW initially for copying and relocation
-            MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS, -1, 0);
-
-        if (map_res == MAP_FAILED) {
-            throw std::runtime_error("Failed to map segment " + phdr.name);
-        }
-
-        // Copy section data
-        auto it = obj.sections.find(phdr.name);
-        if (it != obj.sections.end()) {
-            // Skip BSS copying
-            if (phdr.name != ".bss" && !starts_with(phdr.name, ".bss.")) {
-                if (it->second.data.size() > phdr.size) {
-                    // Should not happen if FLE is valid, but safety check
-                    memcpy(target_addr, it->second.data.data(), phdr.size);
-                } else {
-                    memcpy(target_addr, it->second.data.data(), it->second.data.size());
-                }
-            }
-        } else {
-            throw std::runtime_error("Section data not found for segment: " + phdr.name);
-        }
-
-        // Record section address
-        mod.section_addrs[phdr.name] = (uint64_t)target_addr;
-    }
+    map_segments(obj, mod.load_base, mod.section_addrs);
 
     // Add to specific list location (Global symbol resolution order)
     loaded_modules.push_back(mod);
@@ -329,35 +356,14 @@ void FLE_exec(const FLEObject& obj)
     // But we already have the main object in memory.
     // We should initialize the main module manually.
 
+    auto load_start = std::chrono::steady_clock::now();
     LoadedModule main_mod;
     main_mod.name = obj.name.empty() ? "main" : obj.name;
     main_mod.obj = obj;
     main_mod.load_base = 0;
 
     // Map Main Executable segments
-    for (const auto& phdr : obj.phdrs) {
-        if (phdr.size == 0)
-            continue;
-
-        void* addr = mmap((void*)phdr.vaddr, phdr.size,
-            PROT_READ | PROT_WRITE, // RW for relocations
-            MAP_PRIVATE | MAP_FIXED | MAP_ANONYMOUS, -1, 0);
-
-        if (addr == MAP_FAILED) {
-            throw std::runtime_error(std::string("mmap failed: ") + strerror(errno));
-        }
-
-        auto it = obj.sections.find(phdr.name);
-        if (it == obj.sections.end()) {
-            throw std::runtime_error("Section not found: " + phdr.name);
-        }
-
-        if (phdr.name != ".bss" && !starts_with(phdr.name, ".bss.")) {
-            memcpy(addr, it->second.data.data(), phdr.size);
-        }
-
-        main_mod.section_addrs[phdr.name] = phdr.vaddr;
-    }
+    map_segments(obj, 0, main_mod.section_addrs);
 
     loaded_modules.push_back(main_mod);
     loaded_module_names.insert(main_mod.name);
@@ -367,9 +373,16 @@ void FLE_exec(const FLEObject& obj)
         load_module_recursive(dep);
     }
 
+    time_trace_complete("load", load_start, main_mod.name);
+
     // 2. Perform Relocations for ALL modules
+    auto relocate_start = std::chrono::steady_clock::now();
+    build_global_symbols();
     for (auto& mod : loaded_modules) {
 
+        // Both kinds go through one batch: the engine buckets them by type and checks overflow
+        RelocBatch batch;
+
         // A. Dynamic Relocations (Bonus 1 - Text Relocations for SO, Bonus 2 - GOT for EXE)
         // For .so: dyn_relocs.offset is relative to merged section data (typically .text)
         // For .exe: dyn_relocs.offset is VMA (already resolved during linking)
@@ -385,25 +398,7 @@ void FLE_exec(const FLEObject& obj)
             }
 
             uint64_t sym_addr = resolve_symbol(reloc.symbol);
-
-            switch (reloc.type) {
-            case RelocationType::R_X86_64_64:
-                *(uint64_t*)reloc_addr = sym_addr + reloc.addend;
-                break;
-            case RelocationType::R_X86_64_32:
-                *(uint32_t*)reloc_addr = (uint32_t)(sym_addr + reloc.addend);
-                break;
-            case RelocationType::R_X86_64_32S:
-                *(int32_t*)reloc_addr = (int32_t)(sym_addr + reloc.addend);
-                break;
-            case RelocationType::R_X86_64_PC32:
-                // S + A - P
-                *(uint32_t*)reloc_addr = (uint32_t)(sym_addr + reloc.addend - reloc_addr);
-                break;
-            case RelocationType::R_X86_64_GOTPCREL:
-                *(uint32_t*)reloc_addr = (uint32_t)(sym_addr + reloc.addend - reloc_addr);
-                break;
-            }
+            batch.add(reloc.type, { reinterpret_cast<uint8_t*>(reloc_addr), reloc_addr, sym_addr, reloc.addend, &reloc.symbol });
         }
 
         // B. Section Relocations (Bonus 1 - Text Relocations)
@@ -417,49 +412,24 @@ void FLE_exec(const FLEObject& obj)
             if (addr_it == mod.section_addrs.end())
                 continue;
 
-            // In FLE, section relocs have offset relative to the section start
-            // phdr.vaddr corresponds to the section start VMA relative to Load Base (for SO) or Absolute (for EXE)
-            // Wait, for .so, phdr.vaddr is offset from base.
-            // But we stored the Absolute Runtime Address in section_addrs.
-            // But apply_reloc adds load_base + section_base ...
-
-            // Let's adjust logic.
-            // For Main (.exe), load_base = 0. section_addr is absolute.
-            // For .so, load_base = allocated. section_addr is absolute = load_base + vaddr.
-
-            // Reloc offset is relative to section start.
-            // address = section_absolute_start + reloc.offset.
-            // We can pass `section_absolute_start - load_base` as 2nd arg?
-            // Or just calculate address and adapt lambda.
-
+            // Reloc offset is relative to the section start, and section_addrs holds the
+            // absolute runtime address (load_base + vaddr for .so, vaddr for .exe)
             uint64_t section_runtime_addr = addr_it->second;
 
             for (const auto& reloc : section.relocs) {
                 uint64_t sym_addr = resolve_symbol(reloc.symbol);
                 uint64_t reloc_addr = section_runtime_addr + reloc.offset;
-
-                switch (reloc.type) {
-                case RelocationType::R_X86_64_64:
-                    *(uint64_t*)reloc_addr = sym_addr + reloc.addend;
-                    break;
-                case RelocationType::R_X86_64_32:
-                    *(uint32_t*)reloc_addr = (uint32_t)(sym_addr + reloc.addend);
-                    break;
-                case RelocationType::R_X86_64_32S:
-                    *(int32_t*)reloc_addr = (int32_t)(sym_addr + reloc.addend);
-                    break;
-                case RelocationType::R_X86_64_PC32:
-                    *(uint32_t*)reloc_addr = (uint32_t)(sym_addr + reloc.addend - reloc_addr);
-                    break;
-                case RelocationType::R_X86_64_GOTPCREL:
-                    *(uint32_t*)reloc_addr = (uint32_t)(sym_addr + reloc.addend - reloc_addr);
-                    break;
-                }
+                batch.add(reloc.type, { reinterpret_cast<uint8_t*>(reloc_addr), reloc_addr, sym_addr, reloc.addend, &reloc.symbol });
             }
         }
+
+        batch.apply();
     }
 
+    time_trace_complete("relocate", relocate_start);
+
     // 3. Set Permissions (after all relocations are done)
+    auto protect_start = std::chrono::steady_clock::now();
     for (const auto& mod : loaded_modules) {
         for (const auto& phdr : mod.obj.phdrs) {
             if (phdr.size == 0)
@@ -475,7 +445,12 @@ void FLE_exec(const FLEObject& obj)
         }
     }
 
+    time_trace_complete("protect", protect_start);
+
     // 4. Jump to Entry
+    // 程序通过 exit 系统调用结束，不会回到这里：计时文件要在跳转之前写出
+    time_trace_instant("jump", main_mod.name);
+    time_trace_write();
     using FuncType = int (*)();
     // Entry is VMA. Main EXE base is 0. So entry is absolute.
     FuncType func = reinterpret_cast<FuncType>(obj.entry);
@@ -0,0 +1,275 @@
+#include "fle_cache.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <mutex>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t DEFAULT_MAX_SIZE = 1ull << 30;
+constexpr const char* ENTRY_SUFFIX = ".fleb";
+constexpr const char* TEMP_PREFIX = ".tmp-";
+
+struct CacheConfig {
+    bool enabled = false;
+    std::string dir;
+    uint64_t max_size = DEFAULT_MAX_SIZE;
+};
+
+// "512", "64K", "256M", "2G"
+uint64_t parse_size(const char* text)
+{
+    char* end = nullptr;
+    uint64_t value = std::strtoull(text, &end, 10);
+    if (end == text) {
+        throw std::runtime_error(std::string("Invalid FLE_CACHE_MAX_SIZE: ") + text);
+    }
+    switch (*end) {
+    case '\0':
+        return value;
+    case 'k':
+    case 'K':
+        return value << 10;
+    case 'm':
+    case 'M':
+        return value << 20;
+    case 'g':
+    case 'G':
+        return value << 30;
+    default:
+        throw std::runtime_error(std::string("Invalid FLE_CACHE_MAX_SIZE: ") + text);
+    }
+}
+
+const CacheConfig& config()
+{
+    static const CacheConfig cfg = [] {
+        CacheConfig c;
+        const char* dir = std::getenv("FLE_CACHE_DIR");
+        if (!dir || !*dir) {
+            return c;
+        }
+        c.dir = dir;
+        if (const char* max = std::getenv("FLE_CACHE_MAX_SIZE")) {
+            c.max_size = parse_size(max);
+        }
+        std::error_code ec;
+        fs::create_directories(c.dir, ec);
+        c.enabled = fs::is_directory(c.dir, ec);
+        return c;
+    }();
+    return cfg;
+}
+
+std::atomic<size_t> hit_count { 0 };
+std::atomic<size_t> miss_count { 0 };
+std::atomic<size_t> eviction_count { 0 };
+std::atomic<size_t> temp_serial { 0 };
+std::mutex evict_mutex;
+// Running size of the cache directory: scanned once on the first store, then
+// kept up to date by each store. Other processes' stores are only noticed at
+// the next eviction, which rescans and resets it
+std::atomic<uint64_t> cached_bytes { 0 };
+std::once_flag cached_bytes_scanned;
+
+// Entries are named by content hash and length; a version bump of the binary
+// format shows up as a load error and the entry is rebuilt.
+std::string entry_path(std::string_view content)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "%016llx-%llx%s", static_cast<unsigned long long>(fle_content_hash(content)),
+        static_cast<unsigned long long>(content.size()), ENTRY_SUFFIX);
+    return config().dir + "/" + name;
+}
+
+struct Entry {
+    fs::path path;
+    struct timespec mtime;
+    uint64_t size;
+};
+
+// Cache entries in the directory and their total size
+uint64_t scan_entries(std::vector<Entry>& entries)
+{
+    uint64_t total = 0;
+    std::error_code ec;
+    for (auto it = fs::directory_iterator(config().dir, ec); !ec && it != fs::directory_iterator(); it.increment(ec)) {
+        if (it->path().extension() != ENTRY_SUFFIX) {
+            continue; // Temporaries and foreign files
+        }
+        struct stat st;
+        if (stat(it->path().c_str(), &st) != 0 || !S_ISREG(st.st_mode)) {
+            continue;
+        }
+        entries.push_back({ it->path(), st.st_mtim, static_cast<uint64_t>(st.st_size) });
+        total += st.st_size;
+    }
+    return total;
+}
+
+// Drop least recently used entries until the directory fits in max_size.
+// Hits refresh the mtime, so mtime order is use order.
+void evict()
+{
+    std::lock_guard<std::mutex> lock(evict_mutex);
+    if (cached_bytes.load() <= config().max_size) {
+        return; // Another thread evicted while we waited
+    }
+    std::vector<Entry> entries;
+    uint64_t total = scan_entries(entries);
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.mtime.tv_sec != b.mtime.tv_sec ? a.mtime.tv_sec < b.mtime.tv_sec : a.mtime.tv_nsec < b.mtime.tv_nsec;
+    });
+    std::error_code ec;
+    for (const auto& entry : entries) {
+        if (total <= config().max_size) {
+            break;
+        }
+        // Removing a file another process has mapped is fine: its mapping stays valid
+        if (fs::remove(entry.path, ec)) {
+            total -= entry.size;
+            ++eviction_count;
+        }
+    }
+    cached_bytes = total;
+}
+
+inline uint64_t rotl(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t read64(const char* p)
+{
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline uint32_t read32(const char* p)
+{
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+constexpr uint64_t P1 = 0x9E3779B185EBCA87ull;
+constexpr uint64_t P2 = 0xC2B2AE3D27D4EB4Full;
+constexpr uint64_t P3 = 0x165667B19E3779F9ull;
+constexpr uint64_t P4 = 0x85EBCA77C2B2AE63ull;
+constexpr uint64_t P5 = 0x27D4EB2F165667C5ull;
+
+inline uint64_t round64(uint64_t acc, uint64_t input) { return rotl(acc + input * P2, 31) * P1; }
+inline uint64_t merge64(uint64_t acc, uint64_t val) { return (acc ^ round64(0, val)) * P1 + P4; }
+
+} // namespace
+
+bool fle_cache_enabled()
+{
+    return config().enabled;
+}
+
+bool fle_cache_lookup(std::string_view content, FLEObject& obj)
+{
+    std::string path = entry_path(content);
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        ++miss_count;
+        return false;
+    }
+    try {
+        obj = load_fle_binary(path);
+    } catch (const std::exception&) {
+        // Truncated or written by another format version
+        unlink(path.c_str());
+        ++miss_count;
+        return false;
+    }
+    utimensat(AT_FDCWD, path.c_str(), nullptr, 0);
+    ++hit_count;
+    return true;
+}
+
+void fle_cache_store(std::string_view content, const FLEObject& obj)
+{
+    std::string path = entry_path(content);
+    // Write under a private name and rename, so readers never see a partial entry
+    std::string temp
+        = config().dir + "/" + TEMP_PREFIX + std::to_string(getpid()) + "-" + std::to_string(temp_serial++);
+    try {
+        FLE_write_binary(obj, temp);
+    } catch (const std::exception&) {
+        unlink(temp.c_str());
+        return;
+    }
+    std::call_once(cached_bytes_scanned, [] {
+        std::vector<Entry> entries;
+        cached_bytes = scan_entries(entries);
+    });
+    struct stat st;
+    uint64_t replaced = stat(path.c_str(), &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+    if (rename(temp.c_str(), path.c_str()) != 0 || stat(path.c_str(), &st) != 0) {
+        unlink(temp.c_str());
+        return;
+    }
+    // An entry for the same content may already exist (written by another process); count only the growth
+    uint64_t size = static_cast<uint64_t>(st.st_size);
+    if ((cached_bytes += (size > replaced ? size - replaced : 0)) > config().max_size) {
+        evict();
+    }
+}
+
+FLECacheStats fle_cache_stats()
+{
+    FLECacheStats stats;
+    stats.hits = hit_count.load();
+    stats.misses = miss_count.load();
+    stats.evictions = eviction_count.load();
+    return stats;
+}
+
+// xxHash64 (seed 0)
+uint64_t fle_content_hash(std::string_view data)
+{
+    const char* p = data.data();
+    const char* end = p + data.size();
+    uint64_t h;
+    if (data.size() >= 32) {
+        uint64_t v1 = P1 + P2, v2 = P2, v3 = 0, v4 = 0 - P1;
+        for (; end - p >= 32; p += 32) {
+            v1 = round64(v1, read64(p));
+            v2 = round64(v2, read64(p + 8));
+            v3 = round64(v3, read64(p + 16));
+            v4 = round64(v4, read64(p + 24));
+        }
+        h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+        h = merge64(h, v1);
+        h = merge64(h, v2);
+        h = merge64(h, v3);
+        h = merge64(h, v4);
+    } else {
+        h = P5;
+    }
+    h += data.size();
+    for (; end - p >= 8; p += 8) {
+        h = rotl(h ^ round64(0, read64(p)), 27) * P1 + P4;
+    }
+    if (end - p >= 4) {
+        h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h = rotl(h ^ (static_cast<uint8_t>(*p) * P5), 11) * P1;
+    }
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    h *= P3;
+    h ^= h >> 32;
+    return h;
+}
@@ -0,0 +1,248 @@
+#include "hex_decode.hpp"
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define FLE_HEX_SIMD 1
+#endif
+
+namespace {
+
+// 每个字符的十六进制值；空白为 SPACE，其它字符为 INVALID
+constexpr int8_t SPACE = -2;
+constexpr int8_t INVALID = -1;
+
+struct HexTable {
+    int8_t value[256];
+
+    constexpr HexTable()
+        : value {}
+    {
+        for (int c = 0; c < 256; ++c) {
+            value[c] = INVALID;
+        }
+        for (int c = '0'; c <= '9'; ++c) {
+            value[c] = static_cast<int8_t>(c - '0');
+        }
+        for (int c = 'a'; c <= 'f'; ++c) {
+            value[c] = static_cast<int8_t>(c - 'a' + 10);
+            value[c - 'a' + 'A'] = static_cast<int8_t>(c - 'a' + 10);
+        }
+        for (char c : { ' ', '\t', '\n', '\r', '\v', '\f' }) {
+            value[static_cast<unsigned char>(c)] = SPACE;
+        }
+    }
+};
+
+constexpr HexTable HEX_TABLE;
+
+inline int hex_value(char c) { return HEX_TABLE.value[static_cast<unsigned char>(c)]; }
+inline bool is_space(char c) { return hex_value(c) == SPACE; }
+
+// Same acceptance as `while (ss >> std::hex >> byte)` with a uint32_t byte:
+// stops at the first token that does not start with a hex number, and after
+// a number that runs straight into something else.
+size_t decode_scalar(const char* p, const char* end, uint8_t* out)
+{
+    uint8_t* o = out;
+    while (true) {
+        while (p < end && is_space(*p)) {
+            ++p;
+        }
+        if (p == end) {
+            break;
+        }
+        if (end - p > 2 && p[0] == '0' && (p[1] == 'x' || p[1] == 'X') && hex_value(p[2]) >= 0) {
+            p += 2;
+        }
+        const char* digits = p;
+        uint64_t value = 0;
+        for (int v; p < end && (v = hex_value(*p)) >= 0; ++p) {
+            value = (value << 4) | static_cast<uint64_t>(v);
+            if (value > UINT32_MAX) {
+                return o - out;
+            }
+        }
+        if (p == digits) {
+            break;
+        }
+        *o++ = static_cast<uint8_t>(value);
+        if (p < end && !is_space(*p)) {
+            break;
+        }
+    }
+    return o - out;
+}
+
+#ifdef FLE_HEX_SIMD
+
+/*
+ * A block of 16 " hh" triplets is 48 chars in three 16-byte registers A, B, C.
+ * pshufb gathers the separators, high digits and low digits of all 16
+ * triplets into one register each (-1 lanes read as zero and are OR-ed away).
+ */
+#define Z -1
+#define SHUFFLE_MASKS(X)                                                                                          \
+    X(SEP_A, 0, 3, 6, 9, 12, 15, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z)                                                    \
+    X(SEP_B, Z, Z, Z, Z, Z, Z, 2, 5, 8, 11, 14, Z, Z, Z, Z, Z)                                                    \
+    X(SEP_C, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 1, 4, 7, 10, 13)                                                    \
+    X(HI_A, 1, 4, 7, 10, 13, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z)                                                     \
+    X(HI_B, Z, Z, Z, Z, Z, 0, 3, 6, 9, 12, 15, Z, Z, Z, Z, Z)                                                     \
+    X(HI_C, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 2, 5, 8, 11, 14)                                                     \
+    X(LO_A, 2, 5, 8, 11, 14, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z)                                                     \
+    X(LO_B, Z, Z, Z, Z, Z, 1, 4, 7, 10, 13, Z, Z, Z, Z, Z, Z)                                                     \
+    X(LO_C, Z, Z, Z, Z, Z, Z, Z, Z, Z, Z, 0, 3, 6, 9, 12, 15)
+
+struct alignas(16) ShuffleMask {
+    int8_t lanes[16];
+};
+
+#define DEFINE_MASK(name, ...) constexpr ShuffleMask name = { { __VA_ARGS__ } };
+SHUFFLE_MASKS(DEFINE_MASK)
+#undef DEFINE_MASK
+#undef Z
+
+__attribute__((target("ssse3"))) inline __m128i mask128(const ShuffleMask& m)
+{
+    return _mm_load_si128(reinterpret_cast<const __m128i*>(m.lanes));
+}
+
+__attribute__((target("ssse3"))) inline __m128i gather128(
+    __m128i a, __m128i b, __m128i c, const ShuffleMask& ma, const ShuffleMask& mb, const ShuffleMask& mc)
+{
+    return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, mask128(ma)), _mm_shuffle_epi8(b, mask128(mb))),
+        _mm_shuffle_epi8(c, mask128(mc)));
+}
+
+// ASCII hex digits -> nibbles; `valid` lanes are 0xff where the char was a hex digit
+__attribute__((target("ssse3"))) inline __m128i nibbles128(__m128i x, __m128i& valid)
+{
+    __m128i digit = _mm_sub_epi8(x, _mm_set1_epi8('0'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i alpha = _mm_sub_epi8(_mm_or_si128(x, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_alpha = _mm_cmpeq_epi8(_mm_min_epu8(alpha, _mm_set1_epi8(5)), alpha);
+    valid = _mm_or_si128(is_digit, is_alpha);
+    return _mm_or_si128(_mm_and_si128(is_digit, digit),
+        _mm_and_si128(is_alpha, _mm_add_epi8(alpha, _mm_set1_epi8(10))));
+}
+
+// 48 chars -> 16 bytes; false (nothing written) if the block is not 16 canonical triplets
+__attribute__((target("ssse3"))) bool block_ssse3(const char* p, uint8_t* out)
+{
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 32));
+
+    __m128i sep = gather128(a, b, c, SEP_A, SEP_B, SEP_C);
+    __m128i hi_valid, lo_valid;
+    __m128i hi = nibbles128(gather128(a, b, c, HI_A, HI_B, HI_C), hi_valid);
+    __m128i lo = nibbles128(gather128(a, b, c, LO_A, LO_B, LO_C), lo_valid);
+    __m128i ok = _mm_and_si128(_mm_and_si128(hi_valid, lo_valid), _mm_cmpeq_epi8(sep, _mm_set1_epi8(' ')));
+    if (_mm_movemask_epi8(ok) != 0xFFFF) {
+        return false;
+    }
+    // Nibbles are < 16, so a 16-bit shift never carries into the neighbouring byte
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_or_si128(_mm_slli_epi16(hi, 4), lo));
+    return true;
+}
+
+__attribute__((target("avx2"))) inline __m256i mask256(const ShuffleMask& m)
+{
+    return _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(m.lanes)));
+}
+
+__attribute__((target("avx2"))) inline __m256i gather256(
+    __m256i a, __m256i b, __m256i c, const ShuffleMask& ma, const ShuffleMask& mb, const ShuffleMask& mc)
+{
+    return _mm256_or_si256(
+        _mm256_or_si256(_mm256_shuffle_epi8(a, mask256(ma)), _mm256_shuffle_epi8(b, mask256(mb))),
+        _mm256_shuffle_epi8(c, mask256(mc)));
+}
+
+__attribute__((target("avx2"))) inline __m256i nibbles256(__m256i x, __m256i& valid)
+{
+    __m256i digit = _mm256_sub_epi8(x, _mm256_set1_epi8('0'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i alpha = _mm256_sub_epi8(_mm256_or_si256(x, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_alpha = _mm256_cmpeq_epi8(_mm256_min_epu8(alpha, _mm256_set1_epi8(5)), alpha);
+    valid = _mm256_or_si256(is_digit, is_alpha);
+    return _mm256_or_si256(_mm256_and_si256(is_digit, digit),
+        _mm256_and_si256(is_alpha, _mm256_add_epi8(alpha, _mm256_set1_epi8(10))));
+}
+
+__attribute__((target("avx2"))) inline __m256i load_pair(const char* low, const char* high)
+{
+    return _mm256_inserti128_si256(
+        _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(low))),
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(high)), 1);
+}
+
+// 96 chars -> 32 bytes: each 128-bit lane runs the SSSE3 block on its own 48 chars
+__attribute__((target("avx2"))) bool block_avx2(const char* p, uint8_t* out)
+{
+    __m256i a = load_pair(p, p + 48);
+    __m256i b = load_pair(p + 16, p + 64);
+    __m256i c = load_pair(p + 32, p + 80);
+
+    __m256i sep = gather256(a, b, c, SEP_A, SEP_B, SEP_C);
+    __m256i hi_valid, lo_valid;
+    __m256i hi = nibbles256(gather256(a, b, c, HI_A, HI_B, HI_C), hi_valid);
+    __m256i lo = nibbles256(gather256(a, b, c, LO_A, LO_B, LO_C), lo_valid);
+    __m256i ok = _mm256_and_si256(
+        _mm256_and_si256(hi_valid, lo_valid), _mm256_cmpeq_epi8(sep, _mm256_set1_epi8(' ')));
+    if (_mm256_movemask_epi8(ok) != -1) {
+        return false;
+    }
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_or_si256(_mm256_slli_epi16(hi, 4), lo));
+    return true;
+}
+
+#endif // FLE_HEX_SIMD
+
+// A block may only be taken if the token after it starts with a separator
+inline bool block_fits(const char* p, const char* end, size_t chars)
+{
+    return static_cast<size_t>(end - p) >= chars && (end - p == static_cast<ptrdiff_t>(chars) || p[chars] == ' ');
+}
+
+} // namespace
+
+HexDecoder best_hex_decoder()
+{
+#ifdef FLE_HEX_SIMD
+    static const HexDecoder best = __builtin_cpu_supports("avx2") ? HexDecoder::AVX2
+        : __builtin_cpu_supports("ssse3")                         ? HexDecoder::SSSE3
+                                                                  : HexDecoder::Scalar;
+    return best;
+#else
+    return HexDecoder::Scalar;
+#endif
+}
+
+size_t decode_hex_bytes(std::string_view text, uint8_t* out)
+{
+    return decode_hex_bytes(text, out, best_hex_decoder());
+}
+
+size_t decode_hex_bytes(std::string_view text, uint8_t* out, HexDecoder decoder)
+{
+    const char* p = text.data();
+    const char* end = p + text.size();
+    uint8_t* o = out;
+#ifdef FLE_HEX_SIMD
+    while (decoder != HexDecoder::Scalar) {
+        if (decoder == HexDecoder::AVX2 && block_fits(p, end, 96) && block_avx2(p, o)) {
+            p += 96;
+            o += 32;
+        } else if (block_fits(p, end, 48) && block_ssse3(p, o)) {
+            p += 48;
+            o += 16;
+        } else {
+            break;
+        }
+    }
+#else
+    (void)decoder;
+#endif
+    return (o - out) + decode_scalar(p, end, o);
+}
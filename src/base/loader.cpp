@@ -0,0 +1,778 @@
+#include "fle.hpp"
+#include "fle_cache.hpp"
+#include "fle_tokenizer.hpp"
+#include "hex_decode.hpp"
+#include "mapped_file.hpp"
+#include "string_utils.hpp"
+#include "time_trace.hpp"
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+/**
+ * Builds an FLEObject from section lines as they arrive, in a single pass.
+ *
+ * Symbols are appended in the order their labels appear. A relocation target
+ * that no label in the object defines becomes an UNDEFINED symbol once the
+ * whole object has been seen, in order of first reference.
+ */
+class FLEBuilder {
+public:
+    // symbols_only: record labels and relocation targets but skip section contents
+    explicit FLEBuilder(std::string name, bool symbols_only = false)
+        : symbols_only(symbols_only)
+    {
+        obj.name = std::move(name);
+    }
+
+    FLEObject& object() { return obj; }
+
+    void begin_section(std::string_view name)
+    {
+        current_name = InternedString(name);
+        if (symbols_only) {
+            return;
+        }
+        current = &obj.sections[current_name];
+        *current = FLESection {};
+        current->name = current_name;
+        current->has_symbols = false;
+
+        // 按节头中的大小一次性预留，避免逐字节追加时反复扩容
+        for (const auto& shdr : obj.shdrs) {
+            if (shdr.name == current_name && !(shdr.flags & static_cast<uint32_t>(SHF::NOBITS))) {
+                current->data.reserve(shdr.size);
+                break;
+            }
+        }
+    }
+
+    void end_section()
+    {
+        current = nullptr;
+        current_name = InternedString();
+    }
+
+    void add_line(std::string_view line)
+    {
+        std::string_view content;
+        LineKind kind = classify_line(line, content);
+        if (symbols_only) {
+            scan_line(kind, content);
+            return;
+        }
+        FLESection& section = *current;
+
+        switch (kind) {
+        case LineKind::LocalSymbol:
+        case LineKind::WeakSymbol:
+        case LineKind::GlobalSymbol:
+            add_symbol(kind, content);
+            section.has_symbols = true;
+            break;
+        case LineKind::Data: {
+            // Decode through a stack buffer so the reserved section buffer never over-grows
+            uint8_t bytes[256];
+            if (hex_decoded_size_bound(content) <= sizeof(bytes)) {
+                size_t n = decode_hex_bytes(content, bytes);
+                section.data.insert(section.data.end(), bytes, bytes + n);
+            } else {
+                size_t old_size = section.data.size();
+                section.data.resize(old_size + hex_decoded_size_bound(content));
+                size_t n = decode_hex_bytes(content, section.data.data() + old_size);
+                section.data.resize(old_size + n);
+            }
+            break;
+        }
+        case LineKind::Relocation: {
+            RelocToken token = parse_reloc(content);
+            InternedString symbol_name(token.symbol);
+            reference(symbol_name);
+            Relocation reloc { token.type, section.data.size(), symbol_name, token.addend };
+            if (token.dynamic) {
+                // Section base addresses come from the headers, which may not have been seen yet
+                pending_dyn_relocs.push_back({ current_name, std::move(reloc) });
+            } else {
+                section.relocs.push_back(std::move(reloc));
+            }
+
+            // 根据重定位类型预留空间
+            size_t size = (token.type == RelocationType::R_X86_64_64) ? 8 : 4;
+            section.data.insert(section.data.end(), size, 0);
+            break;
+        }
+        case LineKind::Unknown:
+            break;
+        }
+    }
+
+    FLEObject finish()
+    {
+        if (obj.type == ".ar") {
+            FLEObject ar;
+            ar.name = std::move(obj.name);
+            ar.type = std::move(obj.type);
+            ar.members = std::move(obj.members);
+            ar.symbol_index = std::move(obj.symbol_index);
+            for (const auto& [symbol, indices] : ar.symbol_index) {
+                for (size_t index : indices) {
+                    if (index >= ar.members.size()) {
+                        throw std::runtime_error("Archive symbol index refers to missing member: " + symbol);
+                    }
+                }
+            }
+            return ar;
+        }
+
+        // 只有可执行文件有入口点；只有可执行文件和共享库有程序头
+        if (obj.type != ".exe") {
+            obj.entry = 0;
+        }
+        if (obj.type != ".exe" && obj.type != ".so") {
+            obj.phdrs.clear();
+        }
+
+        for (const auto& name : referenced) {
+            if (!defined.count(name)) {
+                obj.symbols.push_back({ SymbolType::UNDEFINED, "", 0, 0, name });
+            }
+        }
+
+        std::unordered_map<std::string, uint64_t> section_base_addrs;
+        for (const auto& shdr : obj.shdrs) {
+            section_base_addrs[shdr.name] = shdr.addr;
+        }
+        for (const auto& phdr : obj.phdrs) {
+            section_base_addrs.emplace(phdr.name, phdr.vaddr);
+        }
+        for (auto& [section, reloc] : pending_dyn_relocs) {
+            auto base_it = section_base_addrs.find(section);
+            if (base_it == section_base_addrs.end()) {
+                throw std::runtime_error("Dynamic relocation section has no base address: " + section);
+            }
+            reloc.offset += base_it->second;
+            obj.dyn_relocs.push_back(std::move(reloc));
+        }
+
+        return std::move(obj);
+    }
+
+private:
+    struct PendingDynReloc {
+        InternedString section;
+        Relocation reloc; // offset is still section-relative
+    };
+
+    FLEObject obj;
+    bool symbols_only;
+    FLESection* current = nullptr;
+    InternedString current_name;
+    std::unordered_set<InternedString> defined;
+    std::unordered_set<InternedString> referenced_set;
+    std::vector<InternedString> referenced;
+    std::vector<PendingDynReloc> pending_dyn_relocs;
+
+    void reference(InternedString name)
+    {
+        if (referenced_set.insert(name).second) {
+            referenced.push_back(name);
+        }
+    }
+
+    void add_symbol(LineKind kind, std::string_view content)
+    {
+        SymbolToken token;
+        if (!parse_symbol_line(content, token)) {
+            throw std::runtime_error("Invalid symbol: " + trim(std::string(content)));
+        }
+        SymbolType type = kind == LineKind::LocalSymbol ? SymbolType::LOCAL
+            : kind == LineKind::WeakSymbol              ? SymbolType::WEAK
+                                                        : SymbolType::GLOBAL;
+
+        InternedString name(token.name);
+        defined.insert(name);
+        obj.symbols.push_back({ type, current_name, token.offset, token.size, name });
+    }
+
+    static RelocToken parse_reloc(std::string_view content)
+    {
+        RelocToken token;
+        if (!parse_reloc_line(content, token)) {
+            throw std::runtime_error("Invalid relocation: " + trim(std::string(content)));
+        }
+        return token;
+    }
+
+    // Symbols-only pass: yields the same symbol list as a full parse
+    void scan_line(LineKind kind, std::string_view content)
+    {
+        switch (kind) {
+        case LineKind::LocalSymbol:
+        case LineKind::WeakSymbol:
+        case LineKind::GlobalSymbol:
+            add_symbol(kind, content);
+            break;
+        case LineKind::Relocation:
+            reference(InternedString(parse_reloc(content).symbol));
+            break;
+        default:
+            break;
+        }
+    }
+};
+
+bool is_reserved_key(std::string_view key)
+{
+    return key == "type" || key == "entry" || key == "phdrs" || key == "shdrs" || key == "members"
+        || key == "name" || key == "needed" || key == "dyn_relocs" || key == "symbol_index";
+}
+
+// ======================= DOM loader =======================
+
+FLEObject parse_fle_from_json(const json& j, const std::string& name)
+{
+    FLEBuilder builder(name);
+    FLEObject& obj = builder.object();
+    obj.type = j["type"].get<std::string>();
+
+    if (obj.type == ".ar") {
+        if (j.contains("members")) {
+            for (const auto& member_json : j["members"]) {
+                std::string member_name = "";
+                if (member_json.contains("name")) {
+                    member_name = member_json["name"].get<std::string>();
+                }
+                obj.members.push_back(parse_fle_from_json(member_json, member_name));
+            }
+        }
+        if (j.contains("symbol_index")) {
+            for (const auto& [symbol, indices] : j["symbol_index"].items()) {
+                obj.symbol_index[symbol] = indices.get<std::vector<size_t>>();
+            }
+        }
+        return builder.finish();
+    }
+
+    if (j.contains("entry")) {
+        obj.entry = j["entry"].get<size_t>();
+    }
+    if (j.contains("phdrs")) {
+        for (const auto& phdr_json : j["phdrs"]) {
+            obj.phdrs.push_back({ phdr_json["name"].get<std::string>(), phdr_json["vaddr"].get<uint64_t>(),
+                phdr_json["size"].get<uint32_t>(), phdr_json["flags"].get<uint32_t>() });
+        }
+    }
+    if (j.contains("shdrs")) {
+        for (const auto& shdr_json : j["shdrs"]) {
+            obj.shdrs.push_back({ shdr_json["name"].get<std::string>(), shdr_json["type"].get<uint32_t>(),
+                shdr_json["flags"].get<uint32_t>(), shdr_json["addr"].get<uint64_t>(),
+                shdr_json["offset"].get<uint64_t>(), shdr_json["size"].get<uint64_t>(),
+                shdr_json.value("entsize", uint64_t { 0 }), shdr_json.value("align", uint64_t { 0 }) });
+        }
+    }
+    if (j.contains("needed")) {
+        for (const auto& lib : j["needed"]) {
+            obj.needed.push_back(lib.get<std::string>());
+        }
+    }
+
+    for (auto& [key, value] : j.items()) {
+        if (is_reserved_key(key))
+            continue;
+
+        builder.begin_section(key);
+        for (const auto& line : value) {
+            builder.add_line(line.get_ref<const std::string&>());
+        }
+        builder.end_section();
+    }
+
+    return builder.finish();
+}
+
+// ======================= Streaming loader =======================
+
+/**
+ * Minimal pull-style JSON tokenizer over an in-memory buffer.
+ *
+ * Strings without escapes are returned as views into the buffer; escaped
+ * strings are decoded into a scratch buffer that the next call reuses.
+ */
+class JsonReader {
+public:
+    explicit JsonReader(std::string_view text)
+        : begin(text.data())
+        , p(text.data())
+        , end(text.data() + text.size())
+    {
+    }
+
+    void begin_object() { expect('{'); }
+    void begin_array() { expect('['); }
+
+    // Advance to the next member of the current object; false at '}'
+    bool next_key(std::string_view& key)
+    {
+        skip_ws();
+        if (p < end && *p == '}') {
+            ++p;
+            return false;
+        }
+        if (p < end && *p == ',') {
+            ++p;
+        }
+        key = string();
+        expect(':');
+        return true;
+    }
+
+    // Advance to the next element of the current array; false at ']'
+    bool next_element()
+    {
+        skip_ws();
+        if (p < end && *p == ']') {
+            ++p;
+            return false;
+        }
+        if (p < end && *p == ',') {
+            ++p;
+        }
+        return true;
+    }
+
+    std::string_view string()
+    {
+        expect('"');
+        const char* start = p;
+        while (p < end && *p != '"' && *p != '\\') {
+            ++p;
+        }
+        if (p < end && *p == '"') {
+            return { start, static_cast<size_t>(p++ - start) };
+        }
+
+        scratch.assign(start, p);
+        while (p < end && *p != '"') {
+            if (*p != '\\') {
+                scratch.push_back(*p++);
+                continue;
+            }
+            if (++p == end) {
+                break;
+            }
+            switch (char c = *p++) {
+            case 'b':
+                scratch.push_back('\b');
+                break;
+            case 'f':
+                scratch.push_back('\f');
+                break;
+            case 'n':
+                scratch.push_back('\n');
+                break;
+            case 'r':
+                scratch.push_back('\r');
+                break;
+            case 't':
+                scratch.push_back('\t');
+                break;
+            case 'u':
+                append_utf8(unicode_escape());
+                break;
+            default:
+                scratch.push_back(c);
+            }
+        }
+        if (p == end) {
+            error("unterminated string");
+        }
+        ++p;
+        return scratch;
+    }
+
+    uint64_t unsigned_int()
+    {
+        skip_ws();
+        if (p == end || *p < '0' || *p > '9') {
+            error("expected unsigned integer");
+        }
+        uint64_t value = 0;
+        while (p < end && *p >= '0' && *p <= '9') {
+            value = value * 10 + static_cast<uint64_t>(*p++ - '0');
+        }
+        if (p < end && (*p == '.' || *p == 'e' || *p == 'E')) {
+            error("expected integer");
+        }
+        return value;
+    }
+
+    void skip()
+    {
+        skip_ws();
+        if (p == end) {
+            error("unexpected end of input");
+        }
+        switch (*p) {
+        case '{': {
+            ++p;
+            std::string_view key;
+            while (next_key(key)) {
+                skip();
+            }
+            break;
+        }
+        case '[':
+            ++p;
+            while (next_element()) {
+                skip();
+            }
+            break;
+        case '"':
+            string();
+            break;
+        default:
+            while (p < end && *p != ',' && *p != '}' && *p != ']' && !is_ws(*p)) {
+                ++p;
+            }
+        }
+    }
+
+    // Raw position, for coming back to a value that was skipped
+    const char* position() const { return p; }
+    void seek(const char* pos) { p = pos; }
+
+    void finish()
+    {
+        skip_ws();
+        if (p != end) {
+            error("trailing characters");
+        }
+    }
+
+private:
+    const char* begin;
+    const char* p;
+    const char* end;
+    std::string scratch;
+
+    static bool is_ws(char c) { return c == ' ' || c == '\n' || c == '\r' || c == '\t'; }
+
+    void skip_ws()
+    {
+        while (p < end && is_ws(*p)) {
+            ++p;
+        }
+    }
+
+    void expect(char c)
+    {
+        skip_ws();
+        if (p == end || *p != c) {
+            error(std::string("expected '") + c + "'");
+        }
+        ++p;
+    }
+
+    [[noreturn]] void error(const std::string& what) const
+    {
+        throw std::runtime_error("FLE parse error at offset " + std::to_string(p - begin) + ": " + what);
+    }
+
+    uint32_t hex4()
+    {
+        if (end - p < 4) {
+            error("truncated \\u escape");
+        }
+        uint32_t value = 0;
+        for (int i = 0; i < 4; ++i) {
+            char c = *p++;
+            value <<= 4;
+            if (c >= '0' && c <= '9')
+                value |= c - '0';
+            else if (c >= 'a' && c <= 'f')
+                value |= c - 'a' + 10;
+            else if (c >= 'A' && c <= 'F')
+                value |= c - 'A' + 10;
+            else
+                error("bad \\u escape");
+        }
+        return value;
+    }
+
+    uint32_t unicode_escape()
+    {
+        uint32_t cp = hex4();
+        if (cp >= 0xD800 && cp <= 0xDBFF && end - p >= 6 && p[0] == '\\' && p[1] == 'u') {
+            p += 2;
+            uint32_t low = hex4();
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+        return cp;
+    }
+
+    void append_utf8(uint32_t cp)
+    {
+        if (cp < 0x80) {
+            scratch.push_back(static_cast<char>(cp));
+        } else if (cp < 0x800) {
+            scratch.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            scratch.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else if (cp < 0x10000) {
+            scratch.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            scratch.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            scratch.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        } else {
+            scratch.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            scratch.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            scratch.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            scratch.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+};
+
+} // namespace
+
+// Raw JSON text of an archive member, kept alive with the mapping it points into
+struct FLEMemberSource {
+    std::shared_ptr<const MappedFile> file;
+    std::string_view text;
+};
+
+namespace {
+
+/**
+ * Fills an FLEObject straight from the JSON text without building a DOM.
+ * Section lines are handed to FLEBuilder as they are tokenized.
+ */
+class FLEStreamParser {
+public:
+    /**
+     * @param file When given, archive members are only scanned for symbols and
+     *             keep a view into `file` for materialize_member()
+     */
+    explicit FLEStreamParser(std::string_view text, std::shared_ptr<const MappedFile> file = nullptr)
+        : reader(text)
+        , file(std::move(file))
+    {
+    }
+
+    FLEObject parse(const std::string& name)
+    {
+        FLEObject obj = parse_object(name, false, false);
+        reader.finish();
+        return obj;
+    }
+
+    FLEObject parse_member()
+    {
+        FLEObject obj = parse_object("", true, false);
+        reader.finish();
+        return obj;
+    }
+
+private:
+    JsonReader reader;
+    std::shared_ptr<const MappedFile> file;
+
+    FLEObject parse_object(const std::string& name, bool is_member, bool symbols_only)
+    {
+        FLEBuilder builder(name, symbols_only);
+        FLEObject& obj = builder.object();
+        std::vector<std::pair<std::string, const char*>> deferred;
+
+        reader.begin_object();
+        std::string_view key;
+        while (reader.next_key(key)) {
+            if (key == "type") {
+                obj.type = std::string(reader.string());
+            } else if (key == "name") {
+                std::string value(reader.string());
+                if (is_member) {
+                    obj.name = std::move(value);
+                }
+            } else if (key == "entry") {
+                obj.entry = reader.unsigned_int();
+            } else if (key == "phdrs") {
+                parse_program_headers(obj);
+            } else if (key == "shdrs") {
+                parse_section_headers(obj);
+            } else if (key == "needed") {
+                reader.begin_array();
+                while (reader.next_element()) {
+                    obj.needed.emplace_back(reader.string());
+                }
+            } else if (key == "members") {
+                reader.begin_array();
+                while (reader.next_element()) {
+                    if (!file) {
+                        obj.members.push_back(parse_object("", true, false));
+                        continue;
+                    }
+                    const char* start = reader.position();
+                    FLEObject member = parse_object("", true, true);
+                    const char* end = reader.position();
+                    member.lazy_source = std::make_shared<FLEMemberSource>(
+                        FLEMemberSource { file, std::string_view(start, static_cast<size_t>(end - start)) });
+                    obj.members.push_back(std::move(member));
+                }
+            } else if (key == "symbol_index") {
+                parse_symbol_index(obj);
+            } else if (key == "dyn_relocs") {
+                reader.skip();
+            } else if (obj.shdrs.empty() && !symbols_only) {
+                // Our writers emit "shdrs" before the sections; for files that do not,
+                // come back to the section once its size is known
+                deferred.emplace_back(key, reader.position());
+                reader.skip();
+            } else {
+                parse_section(builder, key);
+            }
+        }
+
+        const char* resume = reader.position();
+        for (const auto& [section, pos] : deferred) {
+            reader.seek(pos);
+            parse_section(builder, section);
+        }
+        reader.seek(resume);
+
+        if (obj.type.empty()) {
+            throw std::runtime_error("FLE object has no type");
+        }
+        return builder.finish();
+    }
+
+    void parse_section(FLEBuilder& builder, std::string_view name)
+    {
+        builder.begin_section(name);
+        reader.begin_array();
+        while (reader.next_element()) {
+            builder.add_line(reader.string());
+        }
+        builder.end_section();
+    }
+
+    void parse_symbol_index(FLEObject& obj)
+    {
+        reader.begin_object();
+        std::string_view symbol;
+        while (reader.next_key(symbol)) {
+            auto& indices = obj.symbol_index[InternedString(symbol)];
+            reader.begin_array();
+            while (reader.next_element()) {
+                indices.push_back(reader.unsigned_int());
+            }
+        }
+    }
+
+    void parse_program_headers(FLEObject& obj)
+    {
+        reader.begin_array();
+        while (reader.next_element()) {
+            ProgramHeader phdr {};
+            reader.begin_object();
+            std::string_view key;
+            while (reader.next_key(key)) {
+                if (key == "name")
+                    phdr.name = std::string(reader.string());
+                else if (key == "vaddr")
+                    phdr.vaddr = reader.unsigned_int();
+                else if (key == "size")
+                    phdr.size = reader.unsigned_int();
+                else if (key == "flags")
+                    phdr.flags = static_cast<uint32_t>(reader.unsigned_int());
+                else
+                    reader.skip();
+            }
+            obj.phdrs.push_back(std::move(phdr));
+        }
+    }
+
+    void parse_section_headers(FLEObject& obj)
+    {
+        reader.begin_array();
+        while (reader.next_element()) {
+            SectionHeader shdr {};
+            reader.begin_object();
+            std::string_view key;
+            while (reader.next_key(key)) {
+                if (key == "name")
+                    shdr.name = std::string(reader.string());
+                else if (key == "type")
+                    shdr.type = static_cast<uint32_t>(reader.unsigned_int());
+                else if (key == "flags")
+                    shdr.flags = static_cast<uint32_t>(reader.unsigned_int());
+                else if (key == "addr")
+                    shdr.addr = reader.unsigned_int();
+                else if (key == "offset")
+                    shdr.offset = reader.unsigned_int();
+                else if (key == "size")
+                    shdr.size = reader.unsigned_int();
+                else if (key == "entsize")
+                    shdr.entsize = reader.unsigned_int();
+                else if (key == "align")
+                    shdr.align = reader.unsigned_int();
+                else
+                    reader.skip();
+            }
+            obj.shdrs.push_back(std::move(shdr));
+        }
+    }
+};
+
+// 跳过可执行文件开头的 shebang 行
+std::string_view skip_shebang(std::string_view text)
+{
+    if (text.substr(0, 2) == "#!") {
+        size_t newline = text.find('\n');
+        text.remove_prefix(newline == std::string_view::npos ? 0 : newline + 1);
+    }
+    return text;
+}
+
+} // namespace
+
+FLEObject load_fle(const std::string& file)
+{
+    TimeTraceScope trace("load_fle", file);
+    if (is_binary_fle(file)) {
+        return load_fle_binary(file);
+    }
+
+    auto mapping = MappedFile::open(file);
+    bool cached = fle_cache_enabled();
+    FLEObject obj;
+    if (cached && fle_cache_lookup(mapping->text(), obj)) {
+        obj.name = get_basename(file);
+        return obj;
+    }
+    mapping->advise_sequential();
+    FLEStreamParser parser(skip_shebang(mapping->text()), mapping);
+    obj = parser.parse(get_basename(file));
+    if (cached) {
+        fle_cache_store(mapping->text(), obj);
+    }
+    return obj;
+}
+
+void materialize_member(FLEObject& member)
+{
+    if (!member.lazy_source) {
+        return;
+    }
+    auto source = member.lazy_source;
+    FLEStreamParser parser(source->text);
+    member = parser.parse_member();
+}
+
+FLEObject load_fle_dom(const std::string& file)
+{
+    auto mapping = MappedFile::open(file);
+    std::string_view text = skip_shebang(mapping->text());
+    json j = json::parse(text.begin(), text.end());
+    return parse_fle_from_json(j, get_basename(file));
+}
@@ -1,13 +1,20 @@
 #include "argparse.hpp"
 #include "fle.hpp"
+#include "fle_cache.hpp"
+#include "fle_tokenizer.hpp"
+#include "link_state.hpp"
 #include "string_utils.hpp"
+#include "thread_pool.hpp"
+#include "time_trace.hpp"
+#include <chrono>
 #include <csignal>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <execinfo.h>
 #include <fstream>
 #include <iostream>
-#include <regex>
+#include <sstream>
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -62,284 +69,6 @@ bool file_exists(const std::string& path)
     return fs::exists(path, ec) && fs::is_regular_file(path, ec);
 }
 
-// 辅助函数：解析程序头
-static void parse_program_headers(const json& j, FLEObject& obj)
-{
-    if (j.contains("phdrs")) {
-        for (const auto& phdr_json : j["phdrs"]) {
-            ProgramHeader phdr;
-            phdr.name = phdr_json["name"].get<std::string>();
-            phdr.vaddr = phdr_json["vaddr"].get<uint64_t>();
-            phdr.size = phdr_json["size"].get<uint32_t>();
-            phdr.flags = phdr_json["flags"].get<uint32_t>();
-            obj.phdrs.push_back(phdr);
-        }
-    }
-}
-
-// 辅助函数：解析节头
-static void parse_section_headers(const json& j, FLEObject& obj)
-{
-    if (j.contains("shdrs")) {
-        for (const auto& shdr_json : j["shdrs"]) {
-            SectionHeader shdr;
-            shdr.name = shdr_json["name"].get<std::string>();
-            shdr.type = shdr_json["type"].get<uint32_t>();
-            shdr.flags = shdr_json["flags"].get<uint32_t>();
-            shdr.addr = shdr_json["addr"].get<uint64_t>();
-            shdr.offset = shdr_json["offset"].get<uint64_t>();
-            shdr.size = shdr_json["size"].get<uint64_t>();
-            obj.shdrs.push_back(shdr);
-        }
-    }
-}
-
-// 辅助函数：解析重定位类型
-static RelocationType parse_relocation_type(const std::string& type_str)
-{
-    if (type_str == "rel" || type_str == "dynrel")
-        return RelocationType::R_X86_64_PC32;
-    if (type_str == "abs64" || type_str == "dynabs64")
-        return RelocationType::R_X86_64_64;
-    if (type_str == "abs" || type_str == "dynabs32" || type_str == "abs32")
-        return RelocationType::R_X86_64_32;
-    if (type_str == "abs32s")
-        return RelocationType::R_X86_64_32S;
-    if (type_str == "gotpcrel")
-        return RelocationType::R_X86_64_GOTPCREL;
-    throw std::runtime_error("Invalid relocation type: " + type_str);
-}
-static int64_t parse_addend_literal(std::string literal)
-{
-    literal = trim(literal);
-    if (literal.empty()) {
-        throw std::runtime_error("Empty relocation addend");
-    }
-
-    if (literal.size() > 2 && literal[0] == '0' && (literal[1] == 'x' || literal[1] == 'X')) {
-        literal = literal.substr(2);
-    }
-
-    try {
-        return std::stoll(literal, nullptr, 16);
-    } catch (const std::invalid_argument&) {
-        return std::stoll(literal, nullptr, 10);
-    }
-}
-
-
-
-static FLEObject parse_fle_from_json(const json& j, const std::string& name)
-{
-    FLEObject obj;
-    obj.name = name;
-    obj.type = j["type"].get<std::string>();
-
-    if (obj.type == ".ar") {
-        if (j.contains("members")) {
-            for (const auto& member_json : j["members"]) {
-                std::string member_name = "";
-                if (member_json.contains("name")) {
-                    member_name = member_json["name"].get<std::string>();
-                }
-                obj.members.push_back(parse_fle_from_json(member_json, member_name));
-            }
-        }
-        return obj;
-    }
-
-    // 如果是可执行文件，读取入口点和程序头
-    if (obj.type == ".exe") {
-        if (j.contains("entry")) {
-            obj.entry = j["entry"].get<size_t>();
-        }
-        parse_program_headers(j, obj);
-    }
-
-    // 如果是共享库，读取程序头
-    if (obj.type == ".so") {
-        parse_program_headers(j, obj);
-    }
-
-    // 读取依赖库列表（可执行文件和共享库都可能有）
-    if (j.contains("needed")) {
-        for (const auto& lib : j["needed"]) {
-            obj.needed.push_back(lib.get<std::string>());
-        }
-    }
-
-    std::vector<Relocation> legacy_dyn_relocs;
-    std::vector<Relocation> inline_dyn_relocs;
-
-    parse_section_headers(j, obj);
-
-    std::unordered_map<std::string, Symbol> symbol_table;
-    std::unordered_map<std::string, uint64_t> section_base_addrs;
-
-    for (const auto& shdr : obj.shdrs) {
-        section_base_addrs[shdr.name] = shdr.addr;
-    }
-    for (const auto& phdr : obj.phdrs) {
-        section_base_addrs.emplace(phdr.name, phdr.vaddr);
-    }
-
-    // 第一遍：收集所有符号定义并计算偏移量
-    for (auto& [key, value] : j.items()) {
-        if (key == "type" || key == "entry" || key == "phdrs" || key == "shdrs" || key == "members" || key == "name" || key == "needed" || key == "dyn_relocs")
-            continue;
-
-        // size_t current_offset = 0;
-        for (const auto& line : value) {
-            std::string line_str = line.get<std::string>();
-            size_t colon_pos = line_str.find(':');
-            std::string prefix = line_str.substr(0, colon_pos);
-            std::string content = line_str.substr(colon_pos + 1);
-
-            if (prefix == "🏷️" || prefix == "📎" || prefix == "📤") {
-                std::string name;
-                size_t size, offset;
-                std::istringstream ss(content);
-                ss >> name >> size >> offset;
-
-                name = trim(name);
-                SymbolType type = prefix == "🏷️" ? SymbolType::LOCAL : prefix == "📎" ? SymbolType::WEAK
-                                                                                      : SymbolType::GLOBAL;
-
-                Symbol sym {
-                    type,
-                    std::string(key),
-                    offset,
-                    size,
-                    name
-                };
-
-                symbol_table[name] = sym;
-                obj.symbols.push_back(sym);
-            }
-        }
-    }
-
-    // 第二遍：处理节的内容和重定位
-    for (auto& [key, value] : j.items()) {
-        if (key == "type" || key == "entry" || key == "phdrs" || key == "shdrs" || key == "members" || key == "name" || key == "needed" || key == "dyn_relocs")
-            continue;
-
-        FLESection section;
-        section.has_symbols = false;
-
-        for (const auto& line : value) {
-            std::string line_str = line.get<std::string>();
-            size_t colon_pos = line_str.find(':');
-            std::string prefix = line_str.substr(0, colon_pos);
-            std::string content = line_str.substr(colon_pos + 1);
-
-            if (prefix == "🔢") {
-                std::stringstream ss(content);
-                uint32_t byte;
-                while (ss >> std::hex >> byte) {
-                    section.data.push_back(static_cast<uint8_t>(byte));
-                }
-            } else if (prefix == "❓") {
-                std::string reloc_str = trim(content);
-                std::regex reloc_pattern(R"(\.(rel|abs64|abs|abs32s|gotpcrel|dynrel|dynabs64|dynabs32)\(([\w.@$]+)\s*([-+])\s*([0-9a-fA-FxX]+)\))");
-                std::smatch match;
-
-                if (!std::regex_match(reloc_str, match, reloc_pattern)) {
-                    throw std::runtime_error("Invalid relocation: " + reloc_str);
-                }
-
-                RelocationType type = parse_relocation_type(match[1].str());
-                std::string symbol_name = match[2].str();
-                std::string sign = match[3].str();
-                int64_t append_value = parse_addend_literal(match[4].str());
-                if (sign == "-") {
-                    append_value = -append_value;
-                }
-
-                auto ensure_symbol_exists = [&](const std::string& name) {
-                    auto it = symbol_table.find(name);
-                    if (it == symbol_table.end()) {
-                        Symbol sym {
-                            SymbolType::UNDEFINED,
-                            "",
-                            0,
-                            0,
-                            name
-                        };
-                        symbol_table[name] = sym;
-                        obj.symbols.push_back(sym);
-                    }
-                };
-
-                bool is_dynamic_reloc = match[1].str().rfind("dyn", 0) == 0;
-                if (is_dynamic_reloc) {
-                    ensure_symbol_exists(symbol_name);
-
-                    auto base_it = section_base_addrs.find(key);
-                    if (base_it == section_base_addrs.end()) {
-                        throw std::runtime_error("Dynamic relocation section has no base address: " + key);
-                    }
-
-                    Relocation reloc {
-                        type,
-                        base_it->second + section.data.size(),
-                        symbol_name,
-                        append_value
-                    };
-
-                    inline_dyn_relocs.push_back(reloc);
-
-                    size_t size = (type == RelocationType::R_X86_64_64) ? 8 : 4;
-                    section.data.insert(section.data.end(), size, 0);
-                    continue;
-                }
-
-                Relocation reloc {
-                    type,
-                    section.data.size(),
-                    symbol_name,
-                    append_value
-                };
-
-                ensure_symbol_exists(symbol_name);
-
-                section.relocs.push_back(reloc);
-
-                // 根据重定位类型预留空间
-                size_t size = (type == RelocationType::R_X86_64_64) ? 8 : 4;
-                section.data.insert(section.data.end(), size, 0);
-            } else if (prefix == "🏷️" || prefix == "📎" || prefix == "📤") {
-                section.has_symbols = true;
-            }
-        }
-
-        section.name = key;
-        obj.sections[key] = section;
-    }
-
-    if (!inline_dyn_relocs.empty()) {
-        obj.dyn_relocs = std::move(inline_dyn_relocs);
-    } else {
-        obj.dyn_relocs = std::move(legacy_dyn_relocs);
-    }
-
-    return obj;
-}
-
-FLEObject load_fle(const std::string& file)
-{
-    std::ifstream infile(file);
-    std::string content((std::istreambuf_iterator<char>(infile)),
-        std::istreambuf_iterator<char>());
-
-    if (content.substr(0, 2) == "#!") {
-        content = content.substr(content.find('\n') + 1);
-    }
-
-    json j = json::parse(content);
-    return parse_fle_from_json(j, get_basename(file));
-}
-
 /**
  * 库文件搜索逻辑
  * @param lib_name 库名，如 "m" (对应 -lm)
@@ -409,6 +138,8 @@ void FLE_ar(const std::vector<std::string>& args)
     ar_json["name"] = get_basename(outfile);
 
     json members = json::array();
+    // 符号索引（类似 GNU ar 的 "/" 成员）：已定义的全局/弱符号 -> 定义它的成员下标
+    json symbol_index = json::object();
     for (size_t i = 1; i < args.size(); ++i) {
         std::ifstream infile(args[i]);
         std::string content((std::istreambuf_iterator<char>(infile)),
@@ -418,12 +149,35 @@ void FLE_ar(const std::vector<std::string>& args)
             content = content.substr(content.find('\n') + 1);
         }
 
+        // 每个成员只解析一次：索引直接取自节内容中的全局/弱符号行
+        // (JSON 中的符号行总是定义在所在节里；局部符号不进索引)
         json member_json = json::parse(content);
+        for (const auto& [key, lines] : member_json.items()) {
+            if (!lines.is_array()) {
+                continue;
+            }
+            for (const auto& line : lines) {
+                if (!line.is_string()) {
+                    continue;
+                }
+                std::string_view content;
+                LineKind kind = classify_line(line.get_ref<const std::string&>(), content);
+                SymbolToken sym;
+                if ((kind != LineKind::GlobalSymbol && kind != LineKind::WeakSymbol) || !parse_symbol_line(content, sym)) {
+                    continue;
+                }
+                auto& indices = symbol_index[std::string(sym.name)];
+                if (indices.empty() || indices.back() != i - 1) {
+                    indices.push_back(i - 1);
+                }
+            }
+        }
         // Ensure name is set in the member JSON so it can be recovered
         member_json["name"] = get_basename(args[i]);
         members.push_back(member_json);
     }
 
+    ar_json["symbol_index"] = symbol_index;
     ar_json["members"] = members;
 
     std::ofstream out(outfile);
@@ -469,9 +223,44 @@ int main(int argc, char* argv[])
         return 1;
     }
 
-    std::string tool = "FLE_"s + get_basename(argv[0]);
+    std::string tool_name = get_basename(argv[0]);
+    std::string tool = "FLE_"s + tool_name;
     std::vector<std::string> args(argv + 1, argv + argc);
 
+    // --time-trace[=FILE] 对所有工具有效，但只认写在工具自己的参数之前的
+    // (之后的参数属于 gcc 或被运行的程序，原样保留)；也可以设置环境变量 FLE_TIME_TRACE=FILE。
+    // 不给文件名时写到 <工具名>.time-trace.json
+    std::string trace_file;
+    if (const char* env = std::getenv("FLE_TIME_TRACE"); env && *env) {
+        trace_file = env;
+    }
+    size_t leading = 0;
+    for (; leading < args.size(); ++leading) {
+        if (args[leading] == "--time-trace") {
+            trace_file = tool_name + ".time-trace.json";
+        } else if (args[leading].compare(0, 13, "--time-trace=") == 0) {
+            trace_file = args[leading].substr(13);
+        } else {
+            break;
+        }
+    }
+    args.erase(args.begin(), args.begin() + leading);
+    if (!trace_file.empty()) {
+        time_trace_start(trace_file, tool_name);
+    }
+    // 离开 main 时先记下整个工具的耗时，再写出计时文件 (exec 跳到入口后不返回，由 FLE_exec 自己写)
+    struct TimeTraceWriter {
+        ~TimeTraceWriter()
+        {
+            try {
+                time_trace_write();
+            } catch (const std::exception& e) {
+                std::cerr << "Error: " << e.what() << std::endl;
+            }
+        }
+    } trace_writer;
+    TimeTraceScope trace_total(tool_name.c_str());
+
     try {
         if (tool == "FLE_objdump") {
             if (args.size() != 1) {
@@ -494,6 +283,7 @@ int main(int argc, char* argv[])
             LinkerOptions options;
             std::vector<InputItem> ordered_inputs;
             std::vector<std::string> lib_paths;
+            std::string output_format = "json";
 
             ArgParser parser("ld");
 
@@ -502,6 +292,63 @@ int main(int argc, char* argv[])
             parser.add_flag(options.shared, "-shared", "Create shared library");
             parser.add_flag(options.is_static, "-static", "Static linking");
             parser.add_multi_option(lib_paths, "-L", "Add library search path");
+            parser.add_option(output_format, "--oformat", "Output format: json (default) or binary");
+            parser.add_option_cb("-j, --threads", "Worker threads for loading and relocation (default: one per CPU)", [&](std::string n) {
+                options.threads = std::stoul(n);
+            });
+            parser.add_flag(options.verbose, "--verbose", "Report per-file load times and cache counters");
+            parser.add_flag(options.incremental, "--incremental", "Keep link state next to the output and relink only changed objects");
+            parser.add_flag(options.gc_sections, "--gc-sections", "Drop input sections unreachable from the entry point and exported symbols");
+            parser.add_option_cb("--icf", "Fold identical code sections: all, safe or none (default)", [&](std::string mode) {
+                if (mode == "all") {
+                    options.icf = ICFMode::ALL;
+                } else if (mode == "safe") {
+                    options.icf = ICFMode::SAFE;
+                } else if (mode == "none") {
+                    options.icf = ICFMode::NONE;
+                } else {
+                    throw std::runtime_error("Unknown --icf mode: " + mode + " (expected all, safe or none)");
+                }
+            });
+            parser.add_option_cb("--symbol-ordering-file", "Place sections of the listed symbols first, in file order", [&](std::string path) {
+                std::ifstream file(path);
+                if (!file) {
+                    throw std::runtime_error("Cannot open symbol ordering file: " + path);
+                }
+                // 每行一个符号名，忽略首尾空白和空行
+                std::string line;
+                while (std::getline(file, line)) {
+                    size_t first = line.find_first_not_of(" \t\r");
+                    if (first == std::string::npos) continue;
+                    size_t last = line.find_last_not_of(" \t\r");
+                    options.symbol_ordering.push_back(line.substr(first, last - first + 1));
+                }
+            });
+            parser.add_option_cb("--align-functions", "Align each .text input section to at least N bytes", [&](std::string n) {
+                options.align_functions = std::stoul(n);
+                if (options.align_functions == 0 || (options.align_functions & (options.align_functions - 1)) != 0) {
+                    throw std::runtime_error("--align-functions must be a power of two: " + n);
+                }
+            });
+            parser.add_option_cb("--call-graph-profile", "Cluster .text sections by weighted \"caller callee count\" edges", [&](std::string path) {
+                std::ifstream file(path);
+                if (!file) {
+                    throw std::runtime_error("Cannot open call graph profile: " + path);
+                }
+                std::string line;
+                for (size_t line_no = 1; std::getline(file, line); ++line_no) {
+                    std::istringstream fields(line);
+                    CallGraphProfileEntry entry;
+                    std::string extra;
+                    if (!(fields >> entry.caller)) continue; // 空行
+                    if (!(fields >> entry.callee >> entry.count) || fields >> extra) {
+                        throw std::runtime_error(path + ":" + std::to_string(line_no) + ": expected \"caller callee count\"");
+                    }
+                    options.call_graph_profile.push_back(std::move(entry));
+                }
+            });
+
+            parser.add_option(options.map_file, "-Map, --Map", "Write a link map: input sections, symbols and size per input file");
 
             parser.add_option_cb("-l", "Link library", [&](std::string lib_name) {
                 ordered_inputs.push_back({ InputItem::Library, lib_name });
@@ -524,24 +371,77 @@ int main(int argc, char* argv[])
                 std::cerr << "Error: No inputs\n";
                 return 1;
             }
+            if (output_format != "json" && output_format != "binary") {
+                std::cerr << "Error: Unknown output format: " << output_format << "\n";
+                return 1;
+            }
 
-            std::vector<FLEObject> objects;
             lib_paths.push_back("./");
 
+            std::vector<std::string> input_paths;
             for (const auto& item : ordered_inputs) {
-                if (item.type == InputItem::File) {
-                    objects.push_back(load_fle(item.value));
-                } else if (item.type == InputItem::Library) {
-                    std::string path = find_library(item.value, lib_paths, options.is_static);
-                    objects.push_back(load_fle(path));
-                }
+                input_paths.push_back(item.type == InputItem::Library
+                        ? find_library(item.value, lib_paths, options.is_static)
+                        : item.value);
+            }
+
+            // --incremental：先尝试只重链变化的输入，不行再完整链接
+            LinkState state;
+            FLEObject result;
+            std::string full_link_reason;
+            auto relink_start = std::chrono::steady_clock::now();
+            bool relinked = options.incremental && FLE_ld_relink(state, input_paths, options, result, full_link_reason);
+            if (options.incremental) {
+                time_trace_complete("incremental relink", relink_start, relinked ? "relinked" : full_link_reason);
             }
+            if (!relinked) {
+                if (options.incremental && options.verbose) {
+                    fprintf(stderr, "ld: incremental: full link (%s)\n", full_link_reason.c_str());
+                }
 
-            FLEObject result = FLE_ld(objects, options);
+                // 并行加载输入，但 objects 仍按命令行顺序排列，保证符号解析结果确定
+                std::vector<FLEObject> objects(input_paths.size());
+                std::vector<double> load_ms(input_paths.size());
+                auto load_start = std::chrono::steady_clock::now();
+                {
+                    ThreadPool pool(options.threads);
+                    pool.parallel_for(input_paths.size(), [&](size_t i) {
+                        auto start = std::chrono::steady_clock::now();
+                        objects[i] = load_fle(input_paths[i]);
+                        load_ms[i] = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+                    });
+                }
 
-            FLEWriter writer;
-            FLE_objdump(result, writer);
-            writer.write_to_file(options.outputFile);
+                if (options.verbose) {
+                    for (size_t i = 0; i < objects.size(); ++i) {
+                        fprintf(stderr, "ld: loaded %s in %.2f ms\n", input_paths[i].c_str(), load_ms[i]);
+                    }
+                    double total = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - load_start).count();
+                    fprintf(stderr, "ld: loaded %zu inputs in %.2f ms\n", objects.size(), total);
+                    if (fle_cache_enabled()) {
+                        FLECacheStats stats = fle_cache_stats();
+                        fprintf(stderr, "ld: cache: %zu hits, %zu misses, %zu evictions\n", stats.hits, stats.misses,
+                            stats.evictions);
+                    }
+                }
+
+                result = FLE_ld(objects, options, options.incremental ? &state : nullptr);
+            }
+
+            {
+                TimeTraceScope trace("write output", options.outputFile);
+                if (output_format == "binary") {
+                    FLE_write_binary(result, options.outputFile);
+                } else {
+                    FLEWriter writer;
+                    FLE_objdump(result, writer);
+                    writer.write_to_file(options.outputFile);
+                }
+            }
+            if (options.incremental) {
+                TimeTraceScope trace("save link state");
+                save_link_state(state, input_paths, options);
+            }
         } else if (tool == "FLE_cc") {
             FLE_cc(args);
         } else if (tool == "FLE_readfle") {
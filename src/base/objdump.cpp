@@ -9,10 +9,13 @@ void FLE_objdump(const FLEObject& obj, FLEWriter& writer)
 {
     writer.set_type(obj.type);
 
-    // 如果是可执行文件，写入程序头和入口点
+    // 如果是可执行文件，写入程序头、入口点和节头 (节在段中的位置)
     if (obj.type == ".exe") {
         writer.write_program_headers(obj.phdrs);
         writer.write_entry(obj.entry);
+        if (!obj.shdrs.empty()) {
+            writer.write_section_headers(obj.shdrs);
+        }
     }
 
     // 如果是共享库，也写入程序头和节头
@@ -72,6 +72,10 @@ void FLE_readfle(const FLEObject& obj)
             flags.push_back("EXEC");
         if (shdr.flags & SHF::NOBITS)
             flags.push_back("NOBITS");
+        if (shdr.flags & SHF::MERGE)
+            flags.push_back("MERGE");
+        if (shdr.flags & SHF::STRINGS)
+            flags.push_back("STRINGS");
 
         std::string flag_str;
         for (size_t i = 0; i < flags.size(); i++) {
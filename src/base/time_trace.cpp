@@ -0,0 +1,114 @@
+#include "time_trace.hpp"
+#include "fle.hpp"
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+bool time_trace_on = false;
+
+namespace {
+
+struct TraceEvent {
+    const char* name;
+    std::string detail;
+    double ts;  // 相对启动时刻的微秒数
+    double dur; // 瞬时事件为负
+    uint32_t tid;
+};
+
+std::mutex trace_mutex;
+std::vector<TraceEvent> trace_events;
+std::string trace_path;
+std::string trace_process;
+std::chrono::steady_clock::time_point trace_start;
+
+// 线程按第一次记录事件的先后编号，主线程为 0
+std::atomic<uint32_t> next_tid { 0 };
+
+uint32_t current_tid()
+{
+    thread_local uint32_t tid = next_tid++;
+    return tid;
+}
+
+double micros(std::chrono::steady_clock::duration d)
+{
+    return std::chrono::duration<double, std::micro>(d).count();
+}
+
+void record(const char* name, const std::string& detail, double ts, double dur)
+{
+    uint32_t tid = current_tid();
+    std::lock_guard<std::mutex> lock(trace_mutex);
+    trace_events.push_back({ name, detail, ts, dur, tid });
+}
+
+} // namespace
+
+void time_trace_start(const std::string& path, const std::string& process)
+{
+    std::error_code ec;
+    trace_path = std::filesystem::is_directory(path, ec)
+        ? (std::filesystem::path(path) / (process + "-" + std::to_string(getpid()) + ".json")).string()
+        : path;
+    trace_process = process;
+    trace_start = std::chrono::steady_clock::now();
+    current_tid();
+    time_trace_on = true;
+}
+
+void time_trace_complete(const char* name, std::chrono::steady_clock::time_point start, const std::string& detail)
+{
+    if (!time_trace_enabled()) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    record(name, detail, micros(start - trace_start), micros(now - start));
+}
+
+void time_trace_instant(const char* name, const std::string& detail)
+{
+    if (!time_trace_enabled()) {
+        return;
+    }
+    record(name, detail, micros(std::chrono::steady_clock::now() - trace_start), -1);
+}
+
+void time_trace_write()
+{
+    if (!time_trace_enabled()) {
+        return;
+    }
+    const int pid = getpid();
+    json events = json::array();
+    events.push_back({ { "name", "process_name" }, { "ph", "M" }, { "pid", pid }, { "tid", 0 },
+        { "args", { { "name", trace_process } } } });
+    {
+        std::lock_guard<std::mutex> lock(trace_mutex);
+        for (const auto& e : trace_events) {
+            json event = { { "name", e.name }, { "cat", trace_process }, { "ph", e.dur < 0 ? "i" : "X" },
+                { "ts", e.ts }, { "pid", pid }, { "tid", e.tid } };
+            if (e.dur >= 0) {
+                event["dur"] = e.dur;
+            } else {
+                event["s"] = "p";
+            }
+            if (!e.detail.empty()) {
+                event["args"] = { { "detail", e.detail } };
+            }
+            events.push_back(std::move(event));
+        }
+    }
+    json trace = { { "traceEvents", std::move(events) }, { "displayTimeUnit", "ms" } };
+
+    std::ofstream out(trace_path);
+    if (!out || !(out << trace.dump() << std::endl)) {
+        throw std::runtime_error("Cannot write time trace: " + trace_path);
+    }
+}
@@ -1,17 +1,46 @@
 #include "fle.hpp"
+#include "fle_cache.hpp"
+#include "link_map.hpp"
+#include "link_state.hpp"
+#include "reloc_engine.hpp"
+#include "thread_pool.hpp"
+#include "time_trace.hpp"
+#include <chrono>
 #include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <functional>
 #include <map>
+#include <memory>
+#include <numeric>
+#include <set>
 #include <stdexcept>
 #include <unordered_map>
 #include <unordered_set>
 #include <vector>
 #include <string>
+#include <string_view>
 #include <algorithm>
 
 using namespace std;
 
 static constexpr size_t LOAD_BASE = 0x400000;
 static constexpr size_t PAGE_SIZE = 4096; // 提前定义，为Task6对齐做准备
+static constexpr size_t MERGE_CHUNK = 1 << 20; // Pass 3 并行拷贝的最大块
+
+// 输出段：权限相同的输出节放在同一个段里，按这个顺序排列
+struct OutputSegment {
+    uint32_t flags;
+    vector<const char*> sections;
+};
+static const OutputSegment OUTPUT_SEGMENTS[] = {
+    { PHF::R | PHF::X, { ".text", ".plt" } },
+    { static_cast<uint32_t>(PHF::R), { ".rodata" } },
+    { PHF::R | PHF::W, { ".data", ".got", ".bss" } },
+};
+
+struct MergedInput;
 
 /* ============================================================
  * Internal resolved symbol record
@@ -19,22 +48,45 @@ static constexpr size_t PAGE_SIZE = 4096; // 提前定义，为Task6对齐做准
 struct ResolvedSymbol {
     SymbolType type;   // GLOBAL / WEAK / LOCAL
     size_t addr;       // absolute virtual address
+    uint32_t object = LINK_STATE_NONE; // 定义所在对象 (objs 下标)，增量状态用
+    const MergedInput* merge = nullptr; // 可合并节的节符号：S + A 按 A 所指的片段重新计算
 };
 
 /* ============================================================
  * Helper: make unique local symbol name
  * ============================================================ */
-static string make_local_name(const string& obj, const string& name) {
+string make_local_name(const string& obj, const string& name) {
     return obj + "::" + name;
 }
 
+/* ============================================================
+ * (对象名, 名字) 这类驻留字符串对的哈希，比较/哈希都只涉及指针
+ * ============================================================ */
+using NamePair = pair<InternedString, InternedString>;
+
+struct NamePairHash {
+    size_t operator()(const NamePair& p) const {
+        return hash<InternedString>{}(p.first) * 31 + hash<InternedString>{}(p.second);
+    }
+};
+
 /* ============================================================
  * C++17兼容的字符串前缀判断 (替代C++20 starts_with)
  * 无任何兼容性问题，稳定运行
  * ============================================================ */
 static bool str_starts_with(const string& s, const string& prefix) {
-    if (s.length() < prefix.length()) return false;
-    return s.substr(0, prefix.length()) == prefix;
+    return s.compare(0, prefix.length(), prefix) == 0;
+}
+
+/* ============================================================
+ * 输入节名 → 输出节名；不参与链接的节返回 nullptr
+ * ============================================================ */
+const char* output_section_for(const string& sec_name) {
+    static const char* const targets[] = { ".text", ".plt", ".rodata", ".data", ".got", ".bss" };
+    for (const char* target : targets) {
+        if (str_starts_with(sec_name, target)) return target;
+    }
+    return nullptr;
 }
 
 static size_t align_up(size_t value, size_t align) {
@@ -48,110 +100,977 @@ static const SectionHeader* find_shdr(const FLEObject& obj, const string& name)
     return nullptr;
 }
 
-static size_t get_section_size(const FLEObject& obj, const string& name, const FLESection& sec) {
+size_t get_section_size(const FLEObject& obj, const string& name, const FLESection& sec) {
     const SectionHeader* shdr = find_shdr(obj, name);
     if (!shdr) return sec.data.size();
     if (shdr->size > 0) return shdr->size;
     return sec.data.size();
 }
 
-static void collect_defined_undefined(
-    const vector<FLEObject>& objs,
-    unordered_set<string>& defined,
-    unordered_set<string>& undefined)
-{
-    for (const auto& obj : objs) {
-        for (const auto& sym : obj.symbols) {
-            if (sym.type == SymbolType::LOCAL) {
+size_t get_section_align(const FLEObject& obj, const string& name, const LinkerOptions& options) {
+    const SectionHeader* shdr = find_shdr(obj, name);
+    size_t align = shdr ? max<size_t>(shdr->align, 1) : 1;
+    const char* target = output_section_for(name);
+    if (target && string_view(target) == ".text") {
+        align = max(align, options.align_functions);
+    }
+    return align;
+}
+
+/* ============================================================
+ * 增量布局：每个非空输入节多留 1/4 (至少 32 字节) 的余量，
+ * 修改后的节只要还放得下就能原地替换
+ * ============================================================ */
+size_t incremental_capacity(size_t size) {
+    if (size == 0) return 0;
+    return align_up(size + max<size_t>(size / 4, 32), 16);
+}
+
+const char* exported_section_for(uint64_t addr, const uint64_t (&section_vaddr)[LINK_OUTPUT_SECTION_COUNT]) {
+    if (addr >= section_vaddr[LINK_TEXT] && addr < section_vaddr[LINK_RODATA]) return ".text";
+    if (addr >= section_vaddr[LINK_RODATA] && addr < section_vaddr[LINK_DATA]) return ".rodata";
+    if (addr >= section_vaddr[LINK_DATA] && addr < section_vaddr[LINK_BSS]) return ".data";
+    return ".bss";
+}
+
+/* ============================================================
+ * 归档符号索引: 符号名 → 定义它的成员下标
+ * ar 写出的归档自带索引；旧归档或二进制归档在这里临时建立
+ * ============================================================ */
+static unordered_map<InternedString, vector<size_t>> build_symbol_index(const FLEObject& archive) {
+    unordered_map<InternedString, vector<size_t>> index;
+    for (size_t i = 0; i < archive.members.size(); ++i) {
+        for (const auto& sym : archive.members[i].symbols) {
+            if (sym.type == SymbolType::LOCAL || sym.section.empty()) {
                 continue;
             }
-            if (sym.section.empty()) {
-                undefined.insert(sym.name);
-            } else {
-                defined.insert(sym.name);
+            auto& indices = index[sym.name];
+            if (indices.empty() || indices.back() != i) {
+                indices.push_back(i);
             }
         }
     }
+    return index;
 }
 
-static vector<FLEObject> select_archive_members(const vector<FLEObject>& all_objects) {
-    vector<FLEObject> selected;
+/* ============================================================
+ * 参与链接的对象：普通输入和已解析的归档成员直接引用原对象，
+ * 惰性成员解析出的完整对象存放在 materialized 里 (deque: 地址稳定)
+ * ============================================================ */
+struct SelectedObjects {
+    vector<reference_wrapper<const FLEObject>> objs;
+    deque<FLEObject> materialized;
+    unordered_map<const FLEObject*, const FLEObject*> archive_of; // 选中的归档成员 → 所在归档，供 -Map 使用
+};
+
+// 归档成员的去重键：同一个归档可能在命令行上出现多次
+struct MemberKey {
+    InternedString archive;
+    InternedString member;
+    size_t index;
+
+    bool operator==(const MemberKey& o) const {
+        return archive == o.archive && member == o.member && index == o.index;
+    }
+};
+
+struct MemberKeyHash {
+    size_t operator()(const MemberKey& k) const {
+        return NamePairHash{}({ k.archive, k.member }) * 31 + k.index;
+    }
+};
+
+/* ============================================================
+ * 按工作表选取归档成员
+ * 每个对象加入时只登记自己的定义和新出现的未定义符号；
+ * 每一轮只在索引里查上一轮新出现、且仍未定义的名字，
+ * 本轮选中的成员按 (归档下标, 成员下标) 顺序加入
+ * ============================================================ */
+static SelectedObjects select_archive_members(const vector<FLEObject>& all_objects) {
+    TimeTraceScope trace("select archive members");
+    SelectedObjects result;
     vector<const FLEObject*> archives;
 
+    unordered_set<InternedString> defined;
+    unordered_set<InternedString> seen_undefined;
+    vector<InternedString> pending;
+    auto add_object = [&](const FLEObject& obj) {
+        result.objs.push_back(obj);
+        for (const auto& sym : obj.symbols) {
+            if (sym.type == SymbolType::LOCAL) {
+                continue;
+            }
+            if (!sym.section.empty()) {
+                defined.insert(sym.name);
+            } else if (seen_undefined.insert(sym.name).second) {
+                pending.push_back(sym.name);
+            }
+        }
+    };
+
     for (const auto& obj : all_objects) {
         if (obj.type == ".ar") {
             archives.push_back(&obj);
         } else if (obj.type == ".so") {
             continue;
         } else {
-            selected.push_back(obj);
+            add_object(obj);
         }
     }
 
-    unordered_set<string> selected_member_ids;
-    bool changed = true;
-    while (changed) {
-        changed = false;
+    vector<unordered_map<InternedString, vector<size_t>>> built_indexes(archives.size());
+    vector<const unordered_map<InternedString, vector<size_t>>*> indexes;
+    for (size_t a = 0; a < archives.size(); ++a) {
+        if (archives[a]->symbol_index.empty() && !archives[a]->members.empty()) {
+            built_indexes[a] = build_symbol_index(*archives[a]);
+            indexes.push_back(&built_indexes[a]);
+        } else {
+            indexes.push_back(&archives[a]->symbol_index);
+        }
+    }
+
+    unordered_set<MemberKey, MemberKeyHash> selected_members;
+    vector<InternedString> names;
+    while (!pending.empty()) {
+        names.swap(pending);
+        pending.clear();
 
-        unordered_set<string> defined;
-        unordered_set<string> undefined;
-        collect_defined_undefined(selected, defined, undefined);
-        for (const auto& name : defined) {
-            undefined.erase(name);
+        set<pair<size_t, size_t>> picked;
+        for (const auto& name : names) {
+            if (defined.count(name)) {
+                continue;
+            }
+            for (size_t a = 0; a < archives.size(); ++a) {
+                auto it = indexes[a]->find(name);
+                if (it == indexes[a]->end()) {
+                    continue;
+                }
+                for (size_t i : it->second) {
+                    picked.insert({ a, i });
+                }
+            }
         }
-        if (undefined.empty()) {
-            break;
+
+        for (const auto& [a, i] : picked) {
+            const FLEObject& member = archives[a]->members[i];
+            if (!selected_members.insert({ archives[a]->name, member.name, i }).second) {
+                continue;
+            }
+            // 归档成员按需加载：被选中时才解析节内容和重定位
+            if (member.lazy_source) {
+                result.materialized.push_back(member);
+                materialize_member(result.materialized.back());
+                add_object(result.materialized.back());
+            } else {
+                add_object(member);
+            }
+            result.archive_of[&result.objs.back().get()] = archives[a];
         }
+    }
+
+    return result;
+}
 
-        for (const auto* archive : archives) {
-            for (size_t i = 0; i < archive->members.size(); ++i) {
-                const auto& member = archive->members[i];
-                string member_id = archive->name + "::" + member.name + "#" + to_string(i);
-                if (selected_member_ids.count(member_id)) {
+/* ============================================================
+ * 输入节与链接目标的稠密编号
+ * 输入节按合并顺序编号；局部/全局符号和 GOT/PLT 槽位共用一个目标编号空间。
+ * 每条重定位在 Pass 5 开始时只绑定一次目标编号 (bound 数组与重定位一一对应)，
+ * 应用时顺序遍历即可
+ * ============================================================ */
+static constexpr uint32_t NO_TARGET = UINT32_MAX;
+
+// 一个对象的局部符号: (名字编号, 目标编号)，按名字编号排序
+using LocalTable = vector<pair<uint32_t, uint32_t>>;
+
+static uint32_t find_local(const LocalTable* locals, uint32_t name) {
+    if (!locals) return NO_TARGET;
+    auto it = lower_bound(locals->begin(), locals->end(), make_pair(name, 0u));
+    return it != locals->end() && it->first == name ? it->second : NO_TARGET;
+}
+
+struct InputSection {
+    const FLEObject* obj;
+    const FLESection* sec;
+    const char* target; // 输出节名
+    size_t out_off;     // 在输出节中的偏移
+    size_t addr;        // 虚拟地址
+    uint8_t* out;       // 输出节中对应的数据 (.bss 为 nullptr)
+    const LocalTable* locals = nullptr; // 所属对象的局部符号
+};
+
+/* ============================================================
+ * 符号 → 定义所在的输入节，供布局之前的 --gc-sections / --icf 使用。
+ * 决议规则与 Pass 4/5 一致：先找本对象的局部符号 (同名的后定义者生效)，
+ * 再找胜出的全局定义 (强定义优先，其次是第一个弱定义)
+ * ============================================================ */
+struct SectionRef {
+    const FLEObject* obj;
+    const FLESection* sec;
+    size_t offset; // 符号在节内的偏移
+    bool section_symbol; // 节符号 (名字与节名相同)：指向可合并节时加数决定指向哪个片段
+};
+
+struct SectionSymbols {
+    unordered_map<InternedString, pair<SectionRef, SymbolType>> globals;
+    unordered_map<const FLEObject*, unordered_map<InternedString, SectionRef>> locals;
+
+    explicit SectionSymbols(const vector<reference_wrapper<const FLEObject>>& objs) {
+        for (const FLEObject& obj : objs) {
+            for (const auto& sym : obj.symbols) {
+                if (sym.section.empty() || !output_section_for(sym.section)) continue;
+                auto sec_it = obj.sections.find(sym.section);
+                if (sec_it == obj.sections.end()) continue;
+
+                SectionRef def { &obj, &sec_it->second, sym.offset, sym.name == sym.section };
+                if (sym.type == SymbolType::LOCAL) {
+                    locals[&obj].insert_or_assign(sym.name, def);
                     continue;
                 }
+                // 重复的强定义即使位于之后会被丢弃的节里也要报错，与普通链接一致
+                auto [it, inserted] = globals.try_emplace(sym.name, def, sym.type);
+                if (inserted) continue;
+                if (it->second.second == SymbolType::GLOBAL && sym.type == SymbolType::GLOBAL) {
+                    throw runtime_error("Multiple definition of strong symbol: " + sym.name);
+                }
+                if (it->second.second == SymbolType::WEAK && sym.type == SymbolType::GLOBAL) {
+                    it->second = { def, sym.type };
+                }
+            }
+        }
+    }
+
+    const SectionRef* global(const InternedString& name) const {
+        auto it = globals.find(name);
+        return it != globals.end() ? &it->second.first : nullptr;
+    }
+
+    // 对象 obj 中的重定位目标；未定义 (来自共享库或留作动态重定位) 时返回 nullptr
+    const SectionRef* resolve(const FLEObject* obj, const InternedString& name) const {
+        auto locals_it = locals.find(obj);
+        if (locals_it != locals.end()) {
+            auto it = locals_it->second.find(name);
+            if (it != locals_it->second.end()) return &it->second;
+        }
+        return global(name);
+    }
+};
 
-                bool provides = false;
-                for (const auto& sym : member.symbols) {
-                    if (sym.type == SymbolType::LOCAL || sym.section.empty()) {
-                        continue;
+/* ============================================================
+ * --gc-sections：从根出发沿重定位标记可达的输入节，其余的节不参与链接
+ * 根：可执行文件的入口符号；-shared 时所有全局/弱定义；共享库引用的符号。
+ * 未定义的目标来自共享库，不标记任何节
+ * ============================================================ */
+static unordered_set<const FLESection*> mark_live_sections(const vector<reference_wrapper<const FLEObject>>& shared_libs,
+    const SectionSymbols& symbols, const LinkerOptions& options)
+{
+    TimeTraceScope trace("gc-sections");
+    unordered_set<const FLESection*> live;
+    vector<const SectionRef*> worklist;
+    auto mark = [&](const SectionRef* def) {
+        if (def && live.insert(def->sec).second) {
+            worklist.push_back(def);
+        }
+    };
+
+    if (options.shared) {
+        for (const auto& [name, def] : symbols.globals) {
+            mark(&def.first);
+        }
+    } else {
+        mark(symbols.global(options.entryPoint.empty() ? "_start" : options.entryPoint));
+    }
+    for (const FLEObject& lib : shared_libs) {
+        for (const auto& sym : lib.symbols) {
+            if (sym.section.empty() && sym.type != SymbolType::LOCAL) {
+                mark(symbols.global(sym.name));
+            }
+        }
+    }
+
+    while (!worklist.empty()) {
+        const SectionRef* def = worklist.back();
+        worklist.pop_back();
+        for (const auto& reloc : def->sec->relocs) {
+            mark(symbols.resolve(def->obj, reloc.symbol));
+        }
+    }
+    return live;
+}
+
+/* ============================================================
+ * 可合并节：节头带 SHF::MERGE 和 entsize 的 .rodata.str* / .rodata.cst*
+ * 输入节切成片段 (字符串以 entsize 宽的 0 结尾，常量每 entsize 字节一个)，
+ * 内容相同的片段只保留一份，字符串还做尾部合并 ("bar" 复用 "foobar" 的结尾)。
+ * 合并结果放在输出 .rodata 的开头，按 entsize 从大到小分组排列以保持对齐。
+ * 切分按输入节并行；去重时片段按哈希分到固定数目的分片，各分片并行、
+ * 按链接顺序去重，所以结果与线程数无关
+ * ============================================================ */
+static constexpr size_t MERGE_SHARDS = 64;
+
+// 可以按片段合并的输入节；节内带重定位的不合并
+static const SectionHeader* mergeable_shdr(const FLEObject& obj, const string& name, const FLESection& sec) {
+    const char* target = output_section_for(name);
+    if (!target || string_view(target) != ".rodata" || !sec.relocs.empty()) return nullptr;
+    const SectionHeader* shdr = find_shdr(obj, name);
+    if (!shdr || !(shdr->flags & SHF::MERGE) || shdr->entsize == 0) return nullptr;
+    if (shdr->size == 0 || shdr->size != sec.data.size() || shdr->size % shdr->entsize != 0) return nullptr;
+    return shdr;
+}
+
+struct MergedInput {
+    vector<pair<uint64_t, uint64_t>> pieces; // (片段在输入节中的偏移, 在合并区中的偏移)，按输入偏移递增
+    uint64_t base = 0; // 合并区的虚拟地址 (.rodata 起始)，Pass 2 之后填
+
+    // 输入节内偏移 → 合并区内偏移；落在片段中间的偏移保持片段内的相对位置
+    uint64_t offset_of(uint64_t off) const {
+        auto it = upper_bound(pieces.begin(), pieces.end(), make_pair(off, UINT64_MAX));
+        if (it != pieces.begin()) --it;
+        return it->second + (off - it->first);
+    }
+    uint64_t addr_of(uint64_t off) const { return base + offset_of(off); }
+};
+
+struct MergedSections {
+    vector<MergedInput> inputs;
+    unordered_map<const FLESection*, const MergedInput*> index;
+    vector<uint8_t> data; // 合并区内容
+    size_t align = 1; // 最大的 entsize，合并区起点的对齐要求
+    size_t input_bytes = 0;
+    size_t piece_count = 0;
+    size_t unique_count = 0;
+};
+
+struct PieceKey {
+    string_view text;
+    uint64_t hash;
+    bool operator==(const PieceKey& o) const { return text == o.text; }
+};
+
+struct PieceKeyHash {
+    size_t operator()(const PieceKey& k) const { return k.hash / MERGE_SHARDS; } // 低位已用于分片
+};
+
+static MergedSections merge_sections(const vector<reference_wrapper<const FLEObject>>& objs,
+    const function<bool(const FLESection&)>& is_dropped, ThreadPool& pool)
+{
+    TimeTraceScope trace("merge sections");
+    MergedSections result;
+    vector<const FLESection*> secs;
+    map<pair<uint64_t, bool>, vector<uint32_t>> groups; // (entsize, 是否字符串) → secs 下标，按链接顺序
+    for (const FLEObject& obj : objs) {
+        for (const auto& [sec_name, sec] : obj.sections) {
+            if (is_dropped(sec)) continue;
+            const SectionHeader* shdr = mergeable_shdr(obj, sec_name, sec);
+            if (!shdr) continue;
+            groups[{ shdr->entsize, shdr->flags & SHF::STRINGS }].push_back(static_cast<uint32_t>(secs.size()));
+            secs.push_back(&sec);
+            result.input_bytes += sec.data.size();
+        }
+    }
+    result.inputs.resize(secs.size());
+    for (size_t i = 0; i < secs.size(); ++i) {
+        result.index[secs[i]] = &result.inputs[i];
+    }
+
+    struct Piece {
+        uint64_t off;
+        uint64_t len;
+        uint64_t hash;
+        uint64_t out; // 唯一片段在合并区中的偏移
+        pair<uint32_t, uint32_t> leader; // 内容相同的第一个片段 (组内输入下标, 片段下标)
+    };
+    for (auto group = groups.rbegin(); group != groups.rend(); ++group) {
+        const auto [entsize, strings] = group->first;
+        const vector<uint32_t>& members = group->second;
+        auto text = [&](uint32_t m, const Piece& p) {
+            return string_view(reinterpret_cast<const char*>(secs[members[m]]->data.data()) + p.off, p.len);
+        };
+
+        // 1. 切分并计算哈希 (按输入节并行)
+        vector<vector<Piece>> pieces(members.size());
+        pool.parallel_for(members.size(), [&](size_t m) {
+            const uint8_t* data = secs[members[m]]->data.data();
+            const size_t size = secs[members[m]]->data.size();
+            for (size_t off = 0; off < size;) {
+                size_t end = off + entsize;
+                if (strings) {
+                    // 字符串到 entsize 宽的 0 为止 (含结尾的 0)
+                    size_t at = off;
+                    while (at + entsize <= size && any_of(data + at, data + at + entsize, [](uint8_t b) { return b != 0; })) {
+                        at += entsize;
                     }
-                    if (undefined.count(sym.name)) {
-                        provides = true;
-                        break;
+                    end = min(at + entsize, size);
+                }
+                Piece piece { off, end - off, 0, 0, {} };
+                piece.hash = fle_content_hash(text(static_cast<uint32_t>(m), piece));
+                pieces[m].push_back(piece);
+                off = end;
+            }
+        });
+
+        // 2. 按哈希分片，各分片内按链接顺序找到每个片段的第一次出现 (按分片并行)
+        vector<vector<pair<uint32_t, uint32_t>>> shards(MERGE_SHARDS);
+        for (uint32_t m = 0; m < members.size(); ++m) {
+            for (uint32_t j = 0; j < pieces[m].size(); ++j) {
+                shards[pieces[m][j].hash % MERGE_SHARDS].push_back({ m, j });
+            }
+            result.piece_count += pieces[m].size();
+        }
+        pool.parallel_for(MERGE_SHARDS, [&](size_t s) {
+            unordered_map<PieceKey, pair<uint32_t, uint32_t>, PieceKeyHash> first;
+            first.reserve(shards[s].size());
+            for (const auto& ref : shards[s]) {
+                Piece& piece = pieces[ref.first][ref.second];
+                piece.leader = first.try_emplace({ text(ref.first, piece), piece.hash }, ref).first->second;
+            }
+        });
+
+        // 3. 给唯一片段分配位置；字符串按倒序内容降序排列，是前一个串后缀的串直接指进它的结尾
+        vector<pair<uint32_t, uint32_t>> uniques;
+        for (uint32_t m = 0; m < members.size(); ++m) {
+            for (uint32_t j = 0; j < pieces[m].size(); ++j) {
+                if (pieces[m][j].leader == make_pair(m, j)) uniques.push_back({ m, j });
+            }
+        }
+        result.unique_count += uniques.size();
+        auto piece_text = [&](const pair<uint32_t, uint32_t>& ref) { return text(ref.first, pieces[ref.first][ref.second]); };
+        if (strings) {
+            sort(uniques.begin(), uniques.end(), [&](const auto& a, const auto& b) {
+                string_view x = piece_text(a), y = piece_text(b);
+                for (size_t i = 1; i <= x.size() && i <= y.size(); ++i) {
+                    if (x[x.size() - i] != y[y.size() - i]) {
+                        return static_cast<uint8_t>(x[x.size() - i]) > static_cast<uint8_t>(y[y.size() - i]);
                     }
                 }
+                return x.size() > y.size();
+            });
+        }
+        size_t out = align_up(result.data.size(), entsize);
+        result.data.resize(out);
+        result.align = max(result.align, entsize);
+        string_view prev;
+        uint64_t prev_out = 0;
+        for (const auto& ref : uniques) {
+            Piece& piece = pieces[ref.first][ref.second];
+            string_view str = piece_text(ref);
+            if (strings && prev.size() >= str.size() && (prev.size() - str.size()) % entsize == 0
+                && prev.substr(prev.size() - str.size()) == str) {
+                piece.out = prev_out + prev.size() - str.size();
+                continue;
+            }
+            piece.out = result.data.size();
+            result.data.insert(result.data.end(), str.begin(), str.end());
+            prev = str;
+            prev_out = piece.out;
+        }
 
-                if (provides) {
-                    selected.push_back(member);
-                    selected_member_ids.insert(member_id);
-                    changed = true;
+        // 4. 每个输入节的片段映射 (按输入节并行)
+        pool.parallel_for(members.size(), [&](size_t m) {
+            MergedInput& in = result.inputs[members[m]];
+            in.pieces.reserve(pieces[m].size());
+            for (const Piece& piece : pieces[m]) {
+                in.pieces.push_back({ piece.off, pieces[piece.leader.first][piece.leader.second].out });
+            }
+        });
+    }
+    return result;
+}
+
+/* ============================================================
+ * --icf：在布局之前折叠内容相同的 .text/.rodata 输入节
+ * 两个节等价 ⇔ 大小、字节相同，重定位的 (偏移, 类型, 加数) 相同，且目标等价：
+ * 指向候选节的目标比较 (所在等价类, 节内偏移)，指向合并区的比较合并后的位置，
+ * 其余目标比较定义位置或符号名。
+ * 先按内容分组 (假设候选节之间的目标都等价)，再按目标所在的类反复细分到不动点，
+ * 所以互相递归的一组相同函数也能整体折叠。
+ * safe 模式跳过地址可能被比较的节：被 call/jmp 以外的重定位引用 (取地址、数据引用)，
+ * 或定义了 -shared 导出、共享库引用的全局符号
+ * ============================================================ */
+struct FoldedSection {
+    const FLEObject* obj;
+    const FLESection* sec;
+    const FLEObject* leader_obj; // 保留下来的同类节 (链接顺序最靠前)
+    const FLESection* leader;
+    size_t size;
+};
+
+static vector<FoldedSection> fold_identical_sections(const vector<reference_wrapper<const FLEObject>>& objs,
+    const vector<reference_wrapper<const FLEObject>>& shared_libs, const SectionSymbols& symbols,
+    const unordered_set<const FLESection*>* live, const MergedSections& merged, const LinkerOptions& options)
+{
+    TimeTraceScope trace("icf");
+    auto is_live = [&](const FLESection& sec) { return !live || live->count(&sec); };
+
+    unordered_set<const FLESection*> address_taken;
+    if (options.icf == ICFMode::SAFE) {
+        for (const FLEObject& obj : objs) {
+            for (const auto& [sec_name, sec] : obj.sections) {
+                if (!output_section_for(sec_name) || !is_live(sec)) continue;
+                const bool from_text = string_view(output_section_for(sec_name)) == ".text";
+                for (const auto& reloc : sec.relocs) {
+                    const SectionRef* def = symbols.resolve(&obj, reloc.symbol);
+                    if (!def) continue;
+                    // call rel32 (e8) / jmp rel32 (e9) 只跳转，不暴露地址
+                    bool branch = from_text && reloc.type == RelocationType::R_X86_64_PC32 && reloc.offset > 0
+                        && reloc.offset <= sec.data.size()
+                        && (sec.data[reloc.offset - 1] == 0xe8 || sec.data[reloc.offset - 1] == 0xe9);
+                    if (!branch) address_taken.insert(def->sec);
+                }
+            }
+        }
+        if (options.shared) {
+            for (const auto& [name, def] : symbols.globals) {
+                address_taken.insert(def.first.sec);
+            }
+        }
+        for (const FLEObject& lib : shared_libs) {
+            for (const auto& sym : lib.symbols) {
+                if (sym.section.empty() && sym.type != SymbolType::LOCAL) {
+                    if (const SectionRef* def = symbols.global(sym.name)) address_taken.insert(def->sec);
                 }
             }
         }
     }
 
-    return selected;
+    struct Candidate {
+        const FLEObject* obj;
+        const FLESection* sec;
+        const char* target;
+        size_t size;
+    };
+    vector<Candidate> cands; // 按链接顺序
+    unordered_map<const FLESection*, uint32_t> cand_index;
+    for (const FLEObject& obj : objs) {
+        for (const auto& [sec_name, sec] : obj.sections) {
+            const char* target = output_section_for(sec_name);
+            if (!target || !is_live(sec)) continue;
+            if (string_view(target) != ".text" && string_view(target) != ".rodata") continue;
+            if (merged.index.count(&sec)) continue;
+            size_t size = get_section_size(obj, sec_name, sec);
+            if (size == 0 || size != sec.data.size() || address_taken.count(&sec)) continue;
+            cand_index[&sec] = static_cast<uint32_t>(cands.size());
+            cands.push_back({ &obj, &sec, target, size });
+        }
+    }
+
+    // 规范化的重定位：目标是候选节时记候选下标，否则记定义所在节或符号名
+    enum TargetKind : uint8_t { BY_NAME, BY_SECTION, BY_CANDIDATE };
+    struct NormReloc {
+        size_t offset;
+        RelocationType type;
+        int64_t addend;
+        TargetKind kind;
+        uintptr_t key; // 符号名编号 / 节地址 / 候选下标
+        size_t target_off;
+
+        bool same_content(const NormReloc& o) const {
+            return offset == o.offset && type == o.type && addend == o.addend && kind == o.kind
+                && target_off == o.target_off && (kind == BY_CANDIDATE || key == o.key);
+        }
+    };
+    vector<vector<NormReloc>> norm(cands.size());
+    auto mix = [](uint64_t h, uint64_t v) { return (h ^ v) * 0x9e3779b97f4a7c15ull + (h >> 29); };
+    vector<uint64_t> content_hash(cands.size());
+    for (size_t i = 0; i < cands.size(); ++i) {
+        const Candidate& c = cands[i];
+        uint64_t h = mix(mix(reinterpret_cast<uintptr_t>(c.target), c.size),
+            fle_content_hash({ reinterpret_cast<const char*>(c.sec->data.data()), c.size }));
+        for (const auto& reloc : c.sec->relocs) {
+            NormReloc r { reloc.offset, reloc.type, reloc.addend, BY_NAME, reloc.symbol.index(), 0 };
+            // GOTPCREL 经由按名字分配的 GOT 槽位，只按名字比较
+            const SectionRef* def = reloc.type == RelocationType::R_X86_64_GOTPCREL ? nullptr
+                                                                                    : symbols.resolve(c.obj, reloc.symbol);
+            auto merged_it = def ? merged.index.find(def->sec) : merged.index.end();
+            if (merged_it != merged.index.end()) {
+                // 指向合并区：比较合并后的位置，不同对象里的相同字符串算同一个目标
+                r.kind = BY_SECTION;
+                r.key = reinterpret_cast<uintptr_t>(&merged);
+                r.target_off = merged_it->second->offset_of(def->offset + (def->section_symbol ? r.addend : 0));
+                if (def->section_symbol) r.addend = 0;
+            } else if (def) {
+                auto it = cand_index.find(def->sec);
+                r.kind = it != cand_index.end() ? BY_CANDIDATE : BY_SECTION;
+                r.key = it != cand_index.end() ? it->second : reinterpret_cast<uintptr_t>(def->sec);
+                r.target_off = def->offset;
+            }
+            h = mix(mix(mix(mix(h, r.offset), static_cast<uint64_t>(r.type)), static_cast<uint64_t>(r.addend)),
+                mix(r.kind, (r.kind == BY_CANDIDATE ? 0 : r.key) ^ r.target_off));
+            norm[i].push_back(r);
+        }
+        content_hash[i] = h;
+    }
+
+    auto same_content = [&](size_t a, size_t b) {
+        const Candidate& x = cands[a];
+        const Candidate& y = cands[b];
+        if (x.target != y.target || x.size != y.size || norm[a].size() != norm[b].size()) return false;
+        if (memcmp(x.sec->data.data(), y.sec->data.data(), x.size) != 0) return false;
+        for (size_t k = 0; k < norm[a].size(); ++k) {
+            if (!norm[a][k].same_content(norm[b][k])) return false;
+        }
+        return true;
+    };
+
+    // 初始分组：内容哈希相同再逐字节确认
+    vector<uint32_t> cls(cands.size());
+    size_t class_count = 0;
+    {
+        unordered_map<uint64_t, vector<uint32_t>> leaders; // 内容哈希 → 各类的代表
+        for (uint32_t i = 0; i < cands.size(); ++i) {
+            auto& reps = leaders[content_hash[i]];
+            auto rep = find_if(reps.begin(), reps.end(), [&](uint32_t r) { return same_content(r, i); });
+            if (rep != reps.end()) {
+                cls[i] = cls[*rep];
+            } else {
+                cls[i] = static_cast<uint32_t>(class_count++);
+                reps.push_back(i);
+            }
+        }
+    }
+
+    // 细分：(自己的类, 各候选目标的类) 不同的节分开；类数不再增加即为不动点
+    for (;;) {
+        map<pair<uint32_t, vector<uint32_t>>, uint32_t> ids;
+        vector<uint32_t> next(cands.size());
+        for (size_t i = 0; i < cands.size(); ++i) {
+            pair<uint32_t, vector<uint32_t>> sig { cls[i], {} };
+            for (const auto& r : norm[i]) {
+                if (r.kind == BY_CANDIDATE) sig.second.push_back(cls[r.key]);
+            }
+            next[i] = ids.emplace(move(sig), static_cast<uint32_t>(ids.size())).first->second;
+        }
+        cls.swap(next);
+        if (ids.size() == class_count) break;
+        class_count = ids.size();
+    }
+
+    vector<FoldedSection> folded;
+    vector<uint32_t> leader(class_count, UINT32_MAX);
+    for (uint32_t i = 0; i < cands.size(); ++i) {
+        if (leader[cls[i]] == UINT32_MAX) {
+            leader[cls[i]] = i;
+            continue;
+        }
+        const Candidate& keep = cands[leader[cls[i]]];
+        folded.push_back({ cands[i].obj, cands[i].sec, keep.obj, keep.sec, cands[i].size });
+    }
+    return folded;
+}
+
+/* ============================================================
+ * --symbol-ordering-file：列出的符号所在的 .text/.rodata 输入节按文件顺序排在
+ * 各自输出节的最前面，其余输入节保持原来的顺序 (对象按链接顺序，节按名字)。
+ * 全局符号取胜出的定义，局部符号所有对象中同名的都算；一个节含多个列出的
+ * 符号时按最靠前的一个排。被 --icf 折叠的节改排它的保留者
+ * 返回 输入节 → 名次
+ * ============================================================ */
+using LeaderMap = unordered_map<const FLESection*, const FLESection*>; // --icf 折叠掉的节 → 保留者
+
+static unordered_map<const FLESection*, size_t> order_sections(const vector<string>& order,
+    const SectionSymbols& symbols, const LeaderMap& leader_of)
+{
+    TimeTraceScope trace("symbol ordering");
+    unordered_map<InternedString, size_t> rank;
+    for (const auto& name : order) {
+        if (!rank.try_emplace(InternedString(name), rank.size()).second) {
+            fprintf(stderr, "ld: warning: symbol ordering file: symbol '%s' specified multiple times\n", name.c_str());
+        }
+    }
+
+    unordered_map<const FLESection*, size_t> priority;
+    vector<bool> found(rank.size());
+    auto place = [&](const SectionRef& def, size_t r) {
+        found[r] = true;
+        const FLESection* sec = def.sec;
+        auto leader_it = leader_of.find(sec);
+        if (leader_it != leader_of.end()) sec = leader_it->second;
+        const char* target = output_section_for(sec->name);
+        if (string_view(target) != ".text" && string_view(target) != ".rodata") return;
+        auto [it, inserted] = priority.try_emplace(sec, r);
+        if (!inserted) it->second = min(it->second, r);
+    };
+    for (const auto& [name, def] : symbols.globals) {
+        auto it = rank.find(name);
+        if (it != rank.end()) place(def.first, it->second);
+    }
+    for (const auto& [obj, locals] : symbols.locals) {
+        for (const auto& [name, def] : locals) {
+            auto it = rank.find(name);
+            if (it != rank.end() && !def.section_symbol) place(def, it->second);
+        }
+    }
+    for (const auto& name : order) {
+        if (!found[rank.at(InternedString(name))]) {
+            fprintf(stderr, "ld: warning: symbol ordering file: no such symbol: %s\n", name.c_str());
+            found[rank.at(InternedString(name))] = true; // 重复的名字只警告一次
+        }
+    }
+    return priority;
+}
+
+/* ============================================================
+ * --call-graph-profile：用 C3 算法 (Ottoni & Maher, CGO 2017) 把 .text 输入节
+ * 聚成簇，与 lld 的 CallGraphSort 相同。每个节起初自成一簇；按密度 (被调用
+ * 次数 / 大小) 从高到低，把簇接到最常调用它的调用者所在簇的末尾，除非这条边
+ * 不到它被调用次数的 1/10、合并后超过 MAX_CLUSTER_SIZE 或密度降到原来的
+ * 1/MAX_DENSITY_DEGRADATION 以下。最后各簇按密度排列，热的调用链落在相邻地址上。
+ * 符号按 --symbol-ordering-file 的规则找到节，局部符号只在名字唯一时使用
+ * ============================================================ */
+static constexpr uint64_t MAX_CLUSTER_SIZE = 1024 * 1024;
+static constexpr uint64_t MAX_DENSITY_DEGRADATION = 8;
+
+struct CallGraphEdge {
+    const FLESection* caller;
+    const FLESection* callee;
+    uint64_t count;
+};
+
+template <typename IsDropped>
+static vector<CallGraphEdge> resolve_call_graph(const vector<CallGraphProfileEntry>& profile,
+    const SectionSymbols& symbols, const LeaderMap& leader_of, IsDropped is_dropped)
+{
+    TimeTraceScope trace("resolve call graph");
+    unordered_map<InternedString, const SectionRef*> locals; // 同名局部符号不止一个时为 nullptr
+    unordered_set<InternedString> names;
+    for (const auto& entry : profile) {
+        names.insert(InternedString(entry.caller));
+        names.insert(InternedString(entry.callee));
+    }
+    for (const auto& [obj, table] : symbols.locals) {
+        for (const auto& [name, def] : table) {
+            if (!names.count(name) || def.section_symbol) continue;
+            auto [it, inserted] = locals.try_emplace(name, &def);
+            if (!inserted) it->second = nullptr;
+        }
+    }
+
+    unordered_set<InternedString> warned;
+    auto section_of = [&](const string& name) -> const FLESection* {
+        InternedString key(name);
+        const SectionRef* def = symbols.global(key);
+        if (!def) {
+            auto it = locals.find(key);
+            if (it != locals.end()) def = it->second;
+            if (!def && warned.insert(key).second) {
+                fprintf(stderr, "ld: warning: call graph profile: %s: %s\n",
+                    it != locals.end() ? "ambiguous local symbol" : "no such symbol", name.c_str());
+            }
+        }
+        if (!def) return nullptr;
+        const FLESection* sec = def->sec;
+        auto leader_it = leader_of.find(sec);
+        if (leader_it != leader_of.end()) sec = leader_it->second;
+        return string_view(output_section_for(sec->name)) == ".text" && !is_dropped(*sec) ? sec : nullptr;
+    };
+
+    vector<CallGraphEdge> edges;
+    for (const auto& entry : profile) {
+        const FLESection* caller = section_of(entry.caller);
+        const FLESection* callee = section_of(entry.callee);
+        if (caller && callee && caller != callee && entry.count > 0) {
+            edges.push_back({ caller, callee, entry.count });
+        }
+    }
+    return edges;
+}
+
+// 返回 输入节 → 名次；簇数写入 cluster_count
+static unordered_map<const FLESection*, size_t> call_graph_order(const vector<CallGraphEdge>& edges, size_t& cluster_count)
+{
+    TimeTraceScope trace("call graph sort");
+    struct Cluster {
+        uint64_t size;
+        uint64_t weight = 0; // 簇内各节的被调用次数之和
+        uint64_t initial_weight = 0;
+        size_t next = 0, prev = 0; // 簇内节的环形链表
+        size_t best_pred = SIZE_MAX;
+        uint64_t best_pred_weight = 0;
+        double density() const { return size ? static_cast<double>(weight) / size : 0; }
+    };
+    vector<const FLESection*> nodes;
+    vector<Cluster> clusters;
+    unordered_map<const FLESection*, size_t> node_of;
+    auto node = [&](const FLESection* sec) {
+        auto [it, inserted] = node_of.try_emplace(sec, nodes.size());
+        if (inserted) {
+            nodes.push_back(sec);
+            clusters.push_back({ max<uint64_t>(sec->data.size(), 1) });
+            clusters.back().next = clusters.back().prev = it->second;
+        }
+        return it->second;
+    };
+    for (const auto& e : edges) {
+        size_t from = node(e.caller), to = node(e.callee);
+        Cluster& c = clusters[to];
+        c.weight += e.count;
+        if (e.count > c.best_pred_weight) {
+            c.best_pred = from;
+            c.best_pred_weight = e.count;
+        }
+    }
+    for (auto& c : clusters) {
+        c.initial_weight = c.weight;
+    }
+
+    vector<size_t> sorted(clusters.size());
+    iota(sorted.begin(), sorted.end(), 0);
+    auto by_density = [&](size_t a, size_t b) { return clusters[a].density() > clusters[b].density(); };
+    stable_sort(sorted.begin(), sorted.end(), by_density);
+
+    vector<size_t> leaders(clusters.size());
+    iota(leaders.begin(), leaders.end(), 0);
+    auto leader = [&](size_t v) {
+        while (leaders[v] != v) {
+            leaders[v] = leaders[leaders[v]];
+            v = leaders[v];
+        }
+        return v;
+    };
+    for (size_t l : sorted) {
+        Cluster& c = clusters[l];
+        if (c.best_pred == SIZE_MAX || c.best_pred_weight * 10 <= c.initial_weight) continue;
+        size_t pred_l = leader(c.best_pred);
+        if (pred_l == l) continue;
+        Cluster& pred = clusters[pred_l];
+        if (c.size + pred.size > MAX_CLUSTER_SIZE) continue;
+        double merged_density = static_cast<double>(pred.weight + c.weight) / (pred.size + c.size);
+        if (merged_density < pred.density() / MAX_DENSITY_DEGRADATION) continue;
+
+        // 把 c 的节链接到 pred 的末尾
+        leaders[l] = pred_l;
+        size_t tail1 = pred.prev, tail2 = c.prev;
+        pred.prev = tail2;
+        clusters[tail2].next = pred_l;
+        c.prev = tail1;
+        clusters[tail1].next = l;
+        pred.size += c.size;
+        pred.weight += c.weight;
+        c.size = 0;
+        c.weight = 0;
+    }
+
+    sorted.erase(remove_if(sorted.begin(), sorted.end(), [&](size_t i) { return clusters[i].size == 0; }), sorted.end());
+    stable_sort(sorted.begin(), sorted.end(), by_density);
+    cluster_count = sorted.size();
+    unordered_map<const FLESection*, size_t> priority;
+    for (size_t l : sorted) {
+        size_t i = l;
+        do {
+            priority.emplace(nodes[i], priority.size());
+            i = clusters[i].next;
+        } while (i != l);
+    }
+    return priority;
+}
+
+// 估算跨页调用的次数：调用者和被调用者的起始地址不在同一页时，计入这条边的调用次数
+static uint64_t page_crossings(const vector<CallGraphEdge>& edges, const unordered_map<const FLESection*, size_t>& text_off)
+{
+    uint64_t crossings = 0;
+    for (const auto& e : edges) {
+        if (text_off.at(e.caller) / PAGE_SIZE != text_off.at(e.callee) / PAGE_SIZE) {
+            crossings += e.count;
+        }
+    }
+    return crossings;
 }
 
 /* ============================================================
- * Task 2 + 3 + 4 + 5 完整最终版 (修复所有BUG+无超时+测试全过)
- * ✅ 正确流程：统计大小 → 分配地址 → 合并节 → 符号解析 → 重定位 → 生成程序头
- * ✅ 修复地址重叠BUG，彻底解决超时问题
- * ✅ 完整处理.bss节，无地址计算错误
- * ✅ 所有原有正确逻辑完全保留
+ * 链接主流程
+ * 布局之前：选取归档成员，按选项做 --gc-sections、可合并节去重、--icf 和节排序，
+ * 再收集需要的 GOT/PLT 槽位。之后依次是：
+ *   Pass 1 排列输入节、按对齐算出各自在输出节中的偏移和输出节大小
+ *   Pass 2 按 RX / R / RW 三个段分配输出节的虚拟地址
+ *   Pass 3 一次分配输出节，并行拷贝输入节数据，生成 PLT 桩
+ *   Pass 4 决议符号：全局/弱符号按名字，局部符号按对象，统一编号为链接目标
+ *   Pass 5 为每条重定位绑定目标编号，再按输入节并行批量应用
+ *   Pass 6 生成程序头 (每段一个) 和节头
+ * 最后确定入口，按需写链接映射 (-Map) 和增量链接状态 (--incremental)
  * ============================================================ */
 FLEObject FLE_ld(const vector<FLEObject>& objects,
-                 const LinkerOptions& options)
+                 const LinkerOptions& options,
+                 LinkState* state)
 {
-    const vector<FLEObject> objs = select_archive_members(objects);
-    vector<FLEObject> shared_libs;
+    TimeTraceScope trace("FLE_ld");
+    const SelectedObjects selection = select_archive_members(objects);
+    const auto& objs = selection.objs;
+    vector<reference_wrapper<const FLEObject>> shared_libs;
     for (const auto& obj : objects) {
         if (obj.type == ".so") {
             shared_libs.push_back(obj);
         }
     }
 
+    // 增量链接只支持不带 --gc-sections/--icf/--symbol-ordering-file/--call-graph-profile 的静态可执行文件；
+    // 此时每个输入节按 incremental_capacity 预留空间。-Map 要完整的布局信息，也总是完整链接
+    if (state) {
+        *state = LinkState();
+        state->relinkable = !options.shared && shared_libs.empty() && !options.gc_sections && options.icf == ICFMode::NONE
+            && options.symbol_ordering.empty() && options.call_graph_profile.empty() && options.map_file.empty();
+    }
+    const bool relinkable = state && state->relinkable;
+    auto reserved_size = [&](size_t size) { return relinkable ? incremental_capacity(size) : size; };
+
+    // 下面各遍不按普通输入节布局的节：--gc-sections 丢掉的不可达节、--icf 折叠掉的
+    // 重复节、放进合并区的可合并节。定义在后两者里的符号在 Pass 3 之后另行定位
+    ThreadPool pool(options.threads);
+    unordered_set<const FLESection*> live;
+    vector<FoldedSection> folded;
+    unordered_set<const FLESection*> folded_secs;
+    MergedSections merged;
+    unique_ptr<SectionSymbols> symbols;
+    if (options.gc_sections || options.icf != ICFMode::NONE || !options.symbol_ordering.empty()
+        || !options.call_graph_profile.empty()) {
+        symbols = make_unique<SectionSymbols>(objs);
+    }
+    if (options.gc_sections) {
+        live = mark_live_sections(shared_libs, *symbols, options);
+    }
+    auto is_gc_dropped = [&](const FLESection& sec) { return options.gc_sections && !live.count(&sec); };
+    // 增量布局要求每个输入节的位置只取决于它自己，不合并
+    if (!relinkable) {
+        auto merge_start = chrono::steady_clock::now();
+        merged = merge_sections(objs, is_gc_dropped, pool);
+        if (options.verbose && !merged.inputs.empty()) {
+            fprintf(stderr, "ld: merge: %zu sections, %zu -> %zu bytes (%zu of %zu strings/constants unique) in %.2f ms\n",
+                merged.inputs.size(), merged.input_bytes, merged.data.size(), merged.unique_count, merged.piece_count,
+                chrono::duration<double, milli>(chrono::steady_clock::now() - merge_start).count());
+        }
+    }
+    if (options.icf != ICFMode::NONE) {
+        auto icf_start = chrono::steady_clock::now();
+        folded = fold_identical_sections(objs, shared_libs, *symbols, options.gc_sections ? &live : nullptr, merged, options);
+        size_t saved = 0;
+        for (const auto& f : folded) {
+            folded_secs.insert(f.sec);
+            saved += f.size;
+        }
+        if (options.verbose) {
+            fprintf(stderr, "ld: icf: folded %zu sections, saved %zu bytes in %.2f ms\n", folded.size(), saved,
+                chrono::duration<double, milli>(chrono::steady_clock::now() - icf_start).count());
+        }
+    }
+    auto is_dropped = [&](const FLESection& sec) {
+        return is_gc_dropped(sec) || folded_secs.count(&sec) || merged.index.count(&sec);
+    };
+    // 节的排列顺序：排序文件优先于调用图
+    LeaderMap leader_of;
+    for (const auto& f : folded) {
+        leader_of[f.sec] = f.leader;
+    }
+    unordered_map<const FLESection*, size_t> section_order;
+    vector<CallGraphEdge> call_graph;
+    size_t cluster_count = 0;
+    if (!options.symbol_ordering.empty()) {
+        section_order = order_sections(options.symbol_ordering, *symbols, leader_of);
+        if (!options.call_graph_profile.empty()) {
+            fprintf(stderr, "ld: warning: --call-graph-profile is ignored with --symbol-ordering-file\n");
+        }
+    } else if (!options.call_graph_profile.empty()) {
+        call_graph = resolve_call_graph(options.call_graph_profile, *symbols, leader_of, is_gc_dropped);
+        section_order = call_graph_order(call_graph, cluster_count);
+    }
+
     FLEObject exe;
     exe.type = options.shared ? ".so" : ".exe";
     exe.name = options.outputFile;
@@ -160,21 +1079,18 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
     }
 
     if (!shared_libs.empty()) {
-        for (const auto& lib : shared_libs) {
+        for (const FLEObject& lib : shared_libs) {
             exe.needed.push_back(lib.name);
         }
     }
 
-    // 定义四大输出节，固定不变
-    map<string, FLESection> out_secs = {
-        {".text", {}}, {".plt", {}}, {".rodata", {}}, {".data", {}}, {".got", {}}, {".bss", {}}
-    };
-    // 统计每个输出节的总大小 (BUG1修复核心：先统计)
+    // 每个输出节的总大小 (Pass 1 统计)
     map<string, size_t> sec_total_size = {
         {".text", 0}, {".plt", 0}, {".rodata", 0}, {".data", 0}, {".got", 0}, {".bss", 0}
     };
-    // 输入节映射: (obj名, sec名) → (输出节名, 该节在输出节中的偏移)
-    map<pair<string, string>, pair<string, size_t>> in2out;
+    // 输入节编号: (obj名, sec名) → input_secs 下标
+    vector<InputSection> input_secs;
+    unordered_map<NamePair, uint32_t, NamePairHash> in2out;
     // 输出节的虚拟基地址
     map<string, size_t> sec_vaddr;
     // 输出节的当前写入偏移
@@ -182,8 +1098,9 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
         {".text", 0}, {".plt", 0}, {".rodata", 0}, {".data", 0}, {".got", 0}, {".bss", 0}
     };
 
-    unordered_set<string> defined_static;
-    for (const auto& obj : objs) {
+    auto pass1_start = chrono::steady_clock::now();
+    unordered_set<InternedString> defined_static;
+    for (const FLEObject& obj : objs) {
         for (const auto& sym : obj.symbols) {
             if (sym.section.empty() || sym.type == SymbolType::LOCAL) {
                 continue;
@@ -192,8 +1109,8 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
         }
     }
 
-    unordered_set<string> shared_defined;
-    for (const auto& lib : shared_libs) {
+    unordered_set<InternedString> shared_defined;
+    for (const FLEObject& lib : shared_libs) {
         for (const auto& sym : lib.symbols) {
             if (sym.section.empty() || sym.type == SymbolType::LOCAL) {
                 continue;
@@ -204,15 +1121,16 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
         }
     }
 
-    vector<string> got_order;
-    vector<string> plt_order;
-    unordered_set<string> got_seen;
-    unordered_set<string> plt_seen;
+    vector<InternedString> got_order;
+    vector<InternedString> plt_order;
+    unordered_set<InternedString> got_seen;
+    unordered_set<InternedString> plt_seen;
 
-    for (const auto& obj : objs) {
+    for (const FLEObject& obj : objs) {
         for (const auto& [sec_name, sec] : obj.sections) {
+            if (is_dropped(sec)) continue;
             for (const auto& reloc : sec.relocs) {
-                const string& sym = reloc.symbol;
+                const InternedString& sym = reloc.symbol;
                 if (reloc.type == RelocationType::R_X86_64_GOTPCREL) {
                     if (!got_seen.count(sym)) {
                         got_seen.insert(sym);
@@ -245,96 +1163,210 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
     }
 
     // ============================================================
-    // Pass 1: 第一步【统计】- 遍历所有输入节，计算四大输出节的总大小
+    // Pass 1: 第一步【统计】- 确定输入节的排列顺序，按各自的对齐要求算出它们在
+    // 输出节中的偏移和四大输出节的总大小
+    // 顺序：对象按链接顺序、节按名字；--symbol-ordering-file/--call-graph-profile 排过的节提到前面
     // ============================================================
-    for (const auto& obj : objs) {
+    struct LayoutEntry {
+        const FLEObject* obj;
+        const FLESection* sec;
+        const char* target;
+        size_t priority;
+        size_t size;
+        size_t align;
+        size_t out_off = 0;
+    };
+    vector<LayoutEntry> layout;
+    unordered_map<const FLESection*, size_t> folded_align; // 保留者要满足被折叠进来的节中最大的对齐要求
+    for (const auto& f : folded) {
+        size_t& align = folded_align[f.leader];
+        align = max(align, get_section_align(*f.obj, f.sec->name, options));
+    }
+    size_t gc_dropped = 0, gc_dropped_bytes = 0;
+    vector<LinkMapDropped> gc_discarded; // 只在 -Map 时记录
+    auto file_of = [&](const FLEObject& obj) -> string { // 链接映射中的文件名，归档成员写成 "归档(成员)"
+        auto it = selection.archive_of.find(&obj);
+        return it == selection.archive_of.end() ? string(obj.name) : it->second->name + "(" + obj.name + ")";
+    };
+    for (const FLEObject& obj : objs) {
         for (const auto& [sec_name, sec] : obj.sections) {
-            string target;
-            if (str_starts_with(sec_name, ".text")) target = ".text";
-            else if (str_starts_with(sec_name, ".plt")) target = ".plt";
-            else if (str_starts_with(sec_name, ".rodata")) target = ".rodata";
-            else if (str_starts_with(sec_name, ".data")) target = ".data";
-            else if (str_starts_with(sec_name, ".got")) target = ".got";
-            else if (str_starts_with(sec_name, ".bss")) target = ".bss";
-            else continue;
-            sec_total_size[target] += get_section_size(obj, sec_name, sec);
+            const char* target = output_section_for(sec_name);
+            if (!target) continue;
+            if (is_dropped(sec)) {
+                if (is_gc_dropped(sec)) {
+                    ++gc_dropped;
+                    gc_dropped_bytes += get_section_size(obj, sec_name, sec);
+                    if (!options.map_file.empty()) {
+                        gc_discarded.push_back({ file_of(obj), sec_name, get_section_size(obj, sec_name, sec), "" });
+                    }
+                }
+                continue;
+            }
+            auto order_it = section_order.find(&sec);
+            auto align_it = folded_align.find(&sec);
+            layout.push_back({ &obj, &sec, target, order_it != section_order.end() ? order_it->second : SIZE_MAX,
+                get_section_size(obj, sec_name, sec),
+                max(get_section_align(obj, sec_name, options), align_it != folded_align.end() ? align_it->second : 1) });
+        }
+    }
+    // 调用图中各节在 .text 中的偏移，用来估算排列前后的跨页调用次数
+    auto text_offsets = [&]() {
+        unordered_map<const FLESection*, size_t> offsets;
+        size_t off = 0;
+        for (const auto& entry : layout) {
+            if (string_view(entry.target) != ".text") continue;
+            off = align_up(off, entry.align);
+            offsets[entry.sec] = off;
+            off += reserved_size(entry.size);
+        }
+        return offsets;
+    };
+    uint64_t crossings_before = call_graph.empty() ? 0 : page_crossings(call_graph, text_offsets());
+    uint64_t crossings_after = 0;
+    if (!section_order.empty()) {
+        stable_sort(layout.begin(), layout.end(), [](const auto& a, const auto& b) { return a.priority < b.priority; });
+        if (options.verbose && !options.symbol_ordering.empty()) {
+            size_t ordered = count_if(layout.begin(), layout.end(), [](const auto& e) { return e.priority != SIZE_MAX; });
+            fprintf(stderr, "ld: symbol-ordering: placed %zu sections first\n", ordered);
+        }
+    }
+    if (!call_graph.empty()) {
+        crossings_after = page_crossings(call_graph, text_offsets());
+        if (options.verbose) {
+            fprintf(stderr, "ld: call-graph-profile: %zu edges, %zu sections in %zu clusters, estimated page crossings %llu -> %llu\n",
+                call_graph.size(), section_order.size(), cluster_count, static_cast<unsigned long long>(crossings_before),
+                static_cast<unsigned long long>(crossings_after));
         }
     }
 
+    sec_total_size[".rodata"] = merged.data.size(); // 合并区在 .rodata 开头
+    // 输出节的对齐要求：其中输入节的最大对齐
+    map<string, size_t> sec_align = {
+        {".text", 1}, {".plt", 1}, {".rodata", merged.align}, {".data", 1}, {".got", 8}, {".bss", 1}
+    };
+    size_t align_padding = 0;
+    for (auto& entry : layout) {
+        size_t& total = sec_total_size[entry.target];
+        entry.out_off = align_up(total, entry.align);
+        align_padding += entry.out_off - total;
+        total = entry.out_off + reserved_size(entry.size);
+        sec_align[entry.target] = max(sec_align[entry.target], entry.align);
+    }
+    if (options.verbose && align_padding > 0) {
+        fprintf(stderr, "ld: align: %zu bytes of padding between input sections\n", align_padding);
+    }
+    if (options.gc_sections && options.verbose) {
+        fprintf(stderr, "ld: gc-sections: removed %zu unreachable sections (%zu bytes)\n", gc_dropped, gc_dropped_bytes);
+    }
+
     if (!got_order.empty()) {
         sec_total_size[".got"] += got_order.size() * 8;
     }
     if (!options.shared && !plt_order.empty()) {
         sec_total_size[".plt"] += plt_order.size() * 6;
     }
+    time_trace_complete("pass 1: sizing", pass1_start);
 
     // ============================================================
-    // Pass 2: 第二步【分配地址】- 从0x400000分配连续无重叠的虚拟地址 (BUG1修复核心)
+    // Pass 2: 第二步【分配地址】- 从0x400000分配连续无重叠的虚拟地址
     // ============================================================
+    // 输出节按权限分成三个段：RX (.text .plt)、R (.rodata)、RW (.data .got .bss)。
+    // 每个段从新的一页开始，段内各节按自身对齐紧挨着排列，地址绝对不重叠。
+    // FLE_exec 每个段只需一次 mmap 和一次 mprotect
+    auto pass2_start = chrono::steady_clock::now();
     size_t curr_addr = LOAD_BASE;
-    // 严格按顺序分配：text → rodata → data → bss，地址绝对不重叠
-    curr_addr = align_up(curr_addr, PAGE_SIZE);
-    sec_vaddr[".text"] = curr_addr;
-    curr_addr += sec_total_size[".text"];
-
-    curr_addr = align_up(curr_addr, PAGE_SIZE);
-    sec_vaddr[".plt"] = curr_addr;
-    curr_addr += sec_total_size[".plt"];
-
-    curr_addr = align_up(curr_addr, PAGE_SIZE);
-    sec_vaddr[".rodata"] = curr_addr;
-    curr_addr += sec_total_size[".rodata"];
-
-    curr_addr = align_up(curr_addr, PAGE_SIZE);
-    sec_vaddr[".data"] = curr_addr;
-    curr_addr += sec_total_size[".data"];
-
-    curr_addr = align_up(curr_addr, PAGE_SIZE);
-    sec_vaddr[".got"] = curr_addr;
-    curr_addr += sec_total_size[".got"];
+    for (const auto& segment : OUTPUT_SEGMENTS) {
+        curr_addr = align_up(curr_addr, PAGE_SIZE);
+        for (const char* s : segment.sections) {
+            curr_addr = align_up(curr_addr, sec_align[s]);
+            sec_vaddr[s] = curr_addr;
+            curr_addr += sec_total_size[s];
+        }
+    }
 
-    curr_addr = align_up(curr_addr, PAGE_SIZE);
-    sec_vaddr[".bss"] = curr_addr;
-    curr_addr += sec_total_size[".bss"];
+    uint64_t layout_vaddr[LINK_OUTPUT_SECTION_COUNT];
+    for (size_t i = 0; i < LINK_OUTPUT_SECTION_COUNT; ++i) {
+        layout_vaddr[i] = sec_vaddr[LINK_OUTPUT_SECTIONS[i]];
+    }
+    time_trace_complete("pass 2: address assignment", pass2_start);
 
     // ============================================================
-    // Pass 3: 第三步【合并】- 合并所有输入节到输出节，记录映射关系
+    // Pass 3: 第三步【合并】- 输出节按最终大小一次分配，输入节数据直接拷到最终位置
+    // 输入对象只被引用，每个输入字节在重定位前只拷贝这一次。
+    // 各输入节的偏移先串行算好，拷贝再切成不超过 MERGE_CHUNK 的块并行执行 (--threads)
     // ============================================================
-    for (const auto& obj : objs) {
-        for (const auto& [sec_name, sec] : obj.sections) {
-            string target;
-            if (str_starts_with(sec_name, ".text")) target = ".text";
-            else if (str_starts_with(sec_name, ".plt")) target = ".plt";
-            else if (str_starts_with(sec_name, ".rodata")) target = ".rodata";
-            else if (str_starts_with(sec_name, ".data")) target = ".data";
-            else if (str_starts_with(sec_name, ".got")) target = ".got";
-            else if (str_starts_with(sec_name, ".bss")) target = ".bss";
-            else continue;
+    auto pass3_start = chrono::steady_clock::now();
+    for (const auto& [s, size] : sec_total_size) {
+        if (size > 0 || s == ".bss") { // .bss即使空也要保留
+            FLESection& out = exe.sections[s];
+            out.name = s;
+            if (s != ".bss") {
+                out.data.resize(size); // .bss 不写入文件数据
+            }
+        }
+    }
 
-            size_t sec_size = get_section_size(obj, sec_name, sec);
-            // 记录当前输入节的映射关系
-            in2out[{obj.name, sec_name}] = {target, sec_write_off[target]};
-            // 合并数据到输出节（.bss 不写入文件数据）
-            if (target != ".bss") {
-                out_secs[target].data.insert(out_secs[target].data.end(), sec.data.begin(), sec.data.end());
+    struct CopyJob {
+        uint8_t* dst;
+        const uint8_t* src;
+        size_t len;
+    };
+    vector<CopyJob> copy_jobs;
+    size_t merged_bytes = 0;
+    if (!merged.data.empty()) {
+        copy_jobs.push_back({ exe.sections[".rodata"].data.data(), merged.data.data(), merged.data.size() });
+        sec_write_off[".rodata"] = merged.data.size();
+        for (auto& in : merged.inputs) {
+            in.base = sec_vaddr[".rodata"];
+        }
+    }
+    for (const auto& entry : layout) {
+        const FLEObject& obj = *entry.obj;
+        const FLESection& sec = *entry.sec;
+        const char* target = entry.target;
+
+        size_t& write_off = sec_write_off[target];
+        uint8_t* out = string_view(target) == ".bss" ? nullptr : exe.sections[target].data.data() + entry.out_off;
+        // .text 中对齐留下的空隙填 int3，误跳进去会立即停下
+        if (out && string_view(target) == ".text" && entry.out_off > write_off) {
+            memset(out - (entry.out_off - write_off), 0xcc, entry.out_off - write_off);
+        }
+        // 记录当前输入节的映射关系
+        in2out[{obj.name, sec.name}] = static_cast<uint32_t>(input_secs.size());
+        input_secs.push_back({ &obj, &sec, target, entry.out_off, sec_vaddr[target] + entry.out_off, out });
+        if (out && !sec.data.empty()) {
+            size_t len = min(sec.data.size(), entry.size);
+            for (size_t done = 0; done < len; done += MERGE_CHUNK) {
+                copy_jobs.push_back({ out + done, sec.data.data() + done, min(MERGE_CHUNK, len - done) });
             }
-            // 更新写入偏移
-            sec_write_off[target] += sec_size;
+            merged_bytes += len;
         }
+        // 更新写入偏移
+        write_off = entry.out_off + reserved_size(entry.size);
+    }
+    pool.parallel_for(copy_jobs.size(), [&](size_t i) {
+        memcpy(copy_jobs[i].dst, copy_jobs[i].src, copy_jobs[i].len);
+    });
+    for (const auto& f : folded) {
+        in2out[{ f.obj->name, f.sec->name }] = in2out.at({ f.leader_obj->name, f.leader->name });
+    }
+    if (options.verbose) {
+        fprintf(stderr, "ld: pass 3: merged %zu bytes from %zu sections in %.2f ms\n", merged_bytes, input_secs.size(),
+            chrono::duration<double, milli>(chrono::steady_clock::now() - pass3_start).count());
     }
 
-    unordered_map<string, size_t> got_offset;
-    unordered_map<string, size_t> plt_offset;
+    unordered_map<InternedString, size_t> got_offset;
+    unordered_map<InternedString, size_t> plt_offset;
     if (!got_order.empty()) {
-        out_secs[".got"].data.resize(sec_total_size[".got"], 0);
         for (size_t i = 0; i < got_order.size(); ++i) {
             got_offset[got_order[i]] = i * 8;
         }
     }
     if (!options.shared && !plt_order.empty()) {
-        size_t plt_base = out_secs[".plt"].data.size();
+        uint8_t* plt_data = exe.sections[".plt"].data.data();
+        size_t plt_base = sec_write_off[".plt"];
         for (size_t i = 0; i < plt_order.size(); ++i) {
-            const string& sym = plt_order[i];
+            const InternedString& sym = plt_order[i];
             if (!got_offset.count(sym)) {
                 throw runtime_error("PLT symbol missing GOT entry: " + sym);
             }
@@ -343,64 +1375,105 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
             int32_t got_rel = static_cast<int32_t>(
                 (sec_vaddr[".got"] + got_offset[sym]) - (sec_vaddr[".plt"] + stub_off + 6));
             vector<uint8_t> stub = generate_plt_stub(got_rel);
-            out_secs[".plt"].data.insert(out_secs[".plt"].data.end(), stub.begin(), stub.end());
-        }
-    }
-
-    // 将合并后的节写入可执行文件，包含.bss节 (BUG2修复核心)
-    for (const auto& [s, sec] : out_secs) {
-        if (!sec.data.empty() || s == ".bss") { // .bss即使空也要保留
-            exe.sections[s] = sec;
+            memcpy(plt_data + stub_off, stub.data(), stub.size());
         }
     }
+    time_trace_complete("pass 3: merge", pass3_start);
 
     // ============================================================
-    // Pass 4: 符号解析与决议 (完全复用你的正确逻辑，一行未改！)
+    // Pass 4: 符号解析与决议
+    // 每个定义一个链接目标 (targets)，地址取所在输入节或合并区片段的最终地址；
+    // 局部符号同时写入输出符号表，全局/弱符号决议完后按名字排序导出
     // ============================================================
-    map<string, ResolvedSymbol> symtab;
-    for (const auto& obj : objs) {
+    auto pass4_start = chrono::steady_clock::now();
+    // 全局/弱符号按名字决议；局部符号按对象分表存放。两者都映射到 targets 下标
+    vector<ResolvedSymbol> targets;
+    unordered_map<InternedString, uint32_t> symtab;
+    unordered_map<InternedString, LocalTable> local_symtab;
+    vector<uint32_t> local_first(objs.size() + 1); // 各对象的局部符号在 exe.symbols 中的区间
+    for (uint32_t oi = 0; oi < objs.size(); ++oi) {
+        const FLEObject& obj = objs[oi];
+        local_first[oi] = static_cast<uint32_t>(exe.symbols.size());
         for (const auto& sym : obj.symbols) {
             if (sym.section.empty()) continue;
-            if (!in2out.count({obj.name, sym.section})) continue;
-
-            auto [target_sec, sec_off] = in2out[{obj.name, sym.section}];
-            size_t sym_abs_addr = sec_vaddr[target_sec] + sec_off + sym.offset;
+            // 符号位于普通输入节，或合并区中的某个片段
+            const char* sym_target;
+            size_t sym_out_off;
+            size_t sym_abs_addr;
+            const MergedInput* merge = nullptr;
+            auto in_it = in2out.find({obj.name, sym.section});
+            if (in_it != in2out.end()) {
+                const InputSection& in = input_secs[in_it->second];
+                sym_target = in.target;
+                sym_out_off = in.out_off + sym.offset;
+                sym_abs_addr = in.addr + sym.offset;
+            } else {
+                auto sec_it = obj.sections.find(sym.section);
+                auto merged_it = sec_it != obj.sections.end() ? merged.index.find(&sec_it->second) : merged.index.end();
+                if (merged_it == merged.index.end()) continue;
+                sym_target = ".rodata";
+                sym_out_off = merged_it->second->offset_of(sym.offset);
+                sym_abs_addr = merged_it->second->addr_of(sym.offset);
+                if (sym.name == sym.section) merge = merged_it->second;
+            }
 
             if (sym.type == SymbolType::LOCAL) {
-                string lname = make_local_name(obj.name, sym.name);
-                symtab[lname] = {SymbolType::LOCAL, sym_abs_addr};
+                local_symtab[obj.name].push_back({sym.name.index(), static_cast<uint32_t>(targets.size())});
+                targets.push_back({SymbolType::LOCAL, sym_abs_addr, LINK_STATE_NONE, merge});
                 exe.symbols.push_back({
-                    SymbolType::LOCAL, target_sec,
-                    sym_abs_addr - sec_vaddr[target_sec],
-                    sym.size, lname
+                    SymbolType::LOCAL, sym_target,
+                    sym_out_off,
+                    sym.size, make_local_name(obj.name, sym.name)
                 });
                 continue;
             }
 
-            // 强/弱符号冲突决议规则 (你的代码完全正确)
-            if (!symtab.count(sym.name)) {
-                symtab[sym.name] = {sym.type, sym_abs_addr};
-            } else {
-                auto& old = symtab[sym.name];
-                if (old.type == SymbolType::GLOBAL && sym.type == SymbolType::GLOBAL) {
-                    throw runtime_error("Multiple definition of strong symbol: " + sym.name);
-                }
-                if (old.type == SymbolType::WEAK && sym.type == SymbolType::GLOBAL) {
-                    old = {sym.type, sym_abs_addr};
-                }
+            // 强/弱符号冲突决议：两个强定义报错，强定义覆盖弱定义，弱定义之间第一个生效
+            auto [it, inserted] = symtab.try_emplace(sym.name, static_cast<uint32_t>(targets.size()));
+            if (inserted) {
+                targets.push_back({sym.type, sym_abs_addr, oi});
+                continue;
+            }
+            auto& old = targets[it->second];
+            if (old.type == SymbolType::GLOBAL && sym.type == SymbolType::GLOBAL) {
+                throw runtime_error("Multiple definition of strong symbol: " + sym.name);
+            }
+            if (old.type == SymbolType::WEAK && sym.type == SymbolType::GLOBAL) {
+                old = {sym.type, sym_abs_addr, oi};
             }
         }
     }
+    local_first[objs.size()] = static_cast<uint32_t>(exe.symbols.size());
 
-    // 导出全局/弱符号
-    for (const auto& [name, rsym] : symtab) {
-        if (rsym.type == SymbolType::LOCAL) continue;
-        string sym_sec;
-        if (rsym.addr >= sec_vaddr[".text"] && rsym.addr < sec_vaddr[".rodata"]) sym_sec = ".text";
-        else if (rsym.addr >= sec_vaddr[".rodata"] && rsym.addr < sec_vaddr[".data"]) sym_sec = ".rodata";
-        else if (rsym.addr >= sec_vaddr[".data"] && rsym.addr < sec_vaddr[".bss"]) sym_sec = ".data";
-        else sym_sec = ".bss";
+    // 局部符号表排序；同名的后定义者生效
+    for (auto& [obj_name, locals] : local_symtab) {
+        stable_sort(locals.begin(), locals.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+        LocalTable last;
+        for (const auto& entry : locals) {
+            if (!last.empty() && last.back().first == entry.first) {
+                last.back() = entry;
+            } else {
+                last.push_back(entry);
+            }
+        }
+        locals = move(last);
+    }
+    for (auto& in : input_secs) {
+        auto locals_it = local_symtab.find(in.obj->name);
+        if (locals_it != local_symtab.end()) {
+            in.locals = &locals_it->second;
+        }
+    }
 
+    // 导出全局/弱符号（按名字排序，保证输出确定）
+    vector<pair<InternedString, ResolvedSymbol>> exported;
+    exported.reserve(symtab.size());
+    for (const auto& [name, id] : symtab) {
+        exported.push_back({name, targets[id]});
+    }
+    sort(exported.begin(), exported.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (const auto& [name, rsym] : exported) {
+        const string sym_sec = exported_section_for(rsym.addr, layout_vaddr);
         exe.symbols.push_back({
             rsym.type, sym_sec,
             rsym.addr - sec_vaddr[sym_sec],
@@ -408,99 +1481,136 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
         });
     }
 
+    time_trace_complete("pass 4: symbol resolution", pass4_start);
+
     // ============================================================
-    // Pass 5: 重定位处理 (你的核心公式完全正确，仅适配地址映射)
-    // R_32/32S/PC32/64 全部支持，无任何修改
+    // Pass 5: 重定位处理
+    // R_32/32S/PC32/64/GOTPCREL 由重定位引擎按类型的内核应用
+    // 5a 为每条重定位绑定目标编号，5b 应用。两步都按输入节并行 (--threads)：
+    // 各输入节写入输出节中互不重叠的区间；动态重定位按输入节收集后顺序拼接，
+    // 出错时报告最靠前的输入节里的第一个错误，与串行执行一致
     // ============================================================
-    for (const auto& obj : objs) {
-        for (const auto& [sec_name, sec] : obj.sections) {
-            if (!in2out.count({obj.name, sec_name})) continue;
-            auto [target_sec, sec_off] = in2out[{obj.name, sec_name}];
-            size_t sec_base = sec_vaddr[target_sec];
+    auto pass5_start = chrono::steady_clock::now();
 
-            for (const auto& reloc : sec.relocs) {
-                const string& sym = reloc.symbol;
-                size_t S = 0;
-                string lsym = make_local_name(obj.name, sym);
-                bool resolved = false;
-                if (symtab.count(lsym)) {
-                    S = symtab[lsym].addr;
-                    resolved = true;
-                } else if (symtab.count(sym)) {
-                    S = symtab[sym].addr;
-                    resolved = true;
-                }
+    // 名字 → 目标编号 的平坦表，按驻留字符串编号索引，绑定时不再做哈希查找
+    const size_t name_count = StringInterner::size();
+    vector<uint32_t> global_target(name_count, NO_TARGET);
+    vector<uint32_t> got_target(name_count, NO_TARGET);
+    vector<uint32_t> plt_target(name_count, NO_TARGET);
+    for (const auto& [name, id] : symtab) {
+        global_target[name.index()] = id;
+    }
+    for (const auto& [sym, off] : got_offset) {
+        got_target[sym.index()] = static_cast<uint32_t>(targets.size());
+        targets.push_back({SymbolType::GLOBAL, sec_vaddr[".got"] + off});
+    }
+    for (const auto& [sym, off] : plt_offset) {
+        plt_target[sym.index()] = static_cast<uint32_t>(targets.size());
+        targets.push_back({SymbolType::GLOBAL, sec_vaddr[".plt"] + off});
+    }
 
-                size_t  P = sec_base + sec_off + reloc.offset;
-                int64_t A = reloc.addend;
-                size_t  pos = sec_off + reloc.offset;
+    // 输入节 i 的重定位在 bound 中占据 [reloc_first[i], reloc_first[i + 1])；NO_TARGET 表示动态重定位
+    vector<size_t> reloc_first(input_secs.size() + 1, 0);
+    for (size_t i = 0; i < input_secs.size(); ++i) {
+        reloc_first[i + 1] = reloc_first[i] + input_secs[i].sec->relocs.size();
+    }
+    vector<uint32_t> bound(reloc_first.back(), NO_TARGET);
+    vector<vector<Relocation>> section_dyn_relocs(input_secs.size());
 
-                bool is_external = !defined_static.count(sym) && shared_defined.count(sym);
-                if (reloc.type == RelocationType::R_X86_64_GOTPCREL) {
-                    if (!got_offset.count(sym)) {
-                        throw runtime_error("Missing GOT entry for symbol: " + sym);
-                    }
-                    S = sec_vaddr[".got"] + got_offset[sym];
-                    resolved = true;
-                    if (!options.shared && !is_external && !symtab.count(lsym) && !symtab.count(sym)) {
-                        throw runtime_error("Undefined symbol: " + sym);
-                    }
-                }
+    pool.parallel_for(input_secs.size(), [&](size_t s) {
+        const InputSection& in = input_secs[s];
+        uint32_t* out = bound.data() + reloc_first[s];
+        for (size_t k = 0; k < in.sec->relocs.size(); ++k) {
+            const Relocation& reloc = in.sec->relocs[k];
+            const InternedString& sym = reloc.symbol;
+            switch (reloc.type) {
+                case RelocationType::R_X86_64_32:
+                case RelocationType::R_X86_64_32S:
+                case RelocationType::R_X86_64_PC32:
+                case RelocationType::R_X86_64_64:
+                case RelocationType::R_X86_64_GOTPCREL:
+                    break;
+                default:
+                    throw runtime_error("Unsupported reloc type");
+            }
 
-                if (!resolved) {
-                    if (options.shared) {
-                        if (reloc.type != RelocationType::R_X86_64_GOTPCREL) {
-                            exe.dyn_relocs.push_back({ reloc.type, P, sym, A });
-                            continue;
-                        }
-                    }
-                    if (is_external) {
-                        if (reloc.type == RelocationType::R_X86_64_PC32) {
-                            if (!plt_offset.count(sym)) {
-                                throw runtime_error("Missing PLT entry for symbol: " + sym);
-                            }
-                            S = sec_vaddr[".plt"] + plt_offset[sym];
-                        } else if (reloc.type == RelocationType::R_X86_64_32
-                                   || reloc.type == RelocationType::R_X86_64_32S
-                                   || reloc.type == RelocationType::R_X86_64_64) {
-                            exe.dyn_relocs.push_back({ reloc.type, P, sym, A });
-                            continue;
-                        } else {
-                            throw runtime_error("Unsupported external reloc type");
-                        }
-                        resolved = true;
-                    } else {
-                        throw runtime_error("Undefined symbol: " + sym);
-                    }
+            size_t  P = in.addr + reloc.offset;
+            int64_t A = reloc.addend;
+
+            uint32_t target = find_local(in.locals, sym.index());
+            if (target == NO_TARGET) {
+                target = global_target[sym.index()];
+            }
+            bool defined = target != NO_TARGET;
+
+            // 只有未定义或 GOTPCREL 时才需要判断是否来自共享库
+            auto is_external = [&] { return !defined_static.count(sym) && shared_defined.count(sym); };
+            if (reloc.type == RelocationType::R_X86_64_GOTPCREL) {
+                target = got_target[sym.index()];
+                if (target == NO_TARGET) {
+                    throw runtime_error("Missing GOT entry for symbol: " + sym);
                 }
+                if (!options.shared && !defined && !is_external()) {
+                    throw runtime_error("Undefined symbol: " + sym);
+                }
+            }
 
-                switch (reloc.type) {
-                    case RelocationType::R_X86_64_32:
-                    case RelocationType::R_X86_64_32S: {
-                        uint32_t val = (uint32_t)(S + A);
-                        for (int i=0; i<4; i++) exe.sections[target_sec].data[pos+i] = (val >> 8*i) & 0xff;
-                        break;
-                    }
-                    case RelocationType::R_X86_64_PC32: {
-                        int32_t val = (int32_t)(S + A - P);
-                        for (int i=0; i<4; i++) exe.sections[target_sec].data[pos+i] = (val >> 8*i) & 0xff;
-                        break;
-                    }
-                    case RelocationType::R_X86_64_64: {
-                        uint64_t val = (uint64_t)(S + A);
-                        for (int i=0; i<8; i++) exe.sections[target_sec].data[pos+i] = (val >> 8*i) & 0xff;
-                        break;
-                    }
-                    case RelocationType::R_X86_64_GOTPCREL: {
-                        int32_t val = (int32_t)(S + A - P);
-                        for (int i=0; i<4; i++) exe.sections[target_sec].data[pos+i] = (val >> 8*i) & 0xff;
-                        break;
+            if (target == NO_TARGET) {
+                if (options.shared) {
+                    section_dyn_relocs[s].push_back({ reloc.type, P, sym, A });
+                    continue;
+                }
+                if (!is_external()) {
+                    throw runtime_error("Undefined symbol: " + sym);
+                }
+                if (reloc.type == RelocationType::R_X86_64_PC32) {
+                    target = plt_target[sym.index()];
+                    if (target == NO_TARGET) {
+                        throw runtime_error("Missing PLT entry for symbol: " + sym);
                     }
-                    default:
-                        throw runtime_error("Unsupported reloc type");
+                } else if (reloc.type == RelocationType::R_X86_64_32
+                           || reloc.type == RelocationType::R_X86_64_32S
+                           || reloc.type == RelocationType::R_X86_64_64) {
+                    section_dyn_relocs[s].push_back({ reloc.type, P, sym, A });
+                    continue;
+                } else {
+                    throw runtime_error("Unsupported external reloc type");
                 }
             }
+
+            out[k] = target;
         }
+    });
+    for (auto& relocs : section_dyn_relocs) {
+        exe.dyn_relocs.insert(exe.dyn_relocs.end(), relocs.begin(), relocs.end());
+    }
+
+    auto apply_start = chrono::steady_clock::now();
+    // 交给公共的重定位引擎按类型的内核逐个应用 (检查溢出)。每节的重定位本来就按地址排列，
+    // 分桶只会多拷贝一遍 (bench/bench_reloc 里慢约 20%)，所以这里不用 RelocBatch。
+    // 连续的输入节分成与线程数相同的若干段；段内逐节应用，出错顺序与串行一致
+    size_t chunks = min(pool.size(), input_secs.size());
+    pool.parallel_for(chunks, [&](size_t c) {
+        for (size_t s = input_secs.size() * c / chunks; s < input_secs.size() * (c + 1) / chunks; ++s) {
+            const InputSection& in = input_secs[s];
+            const uint32_t* bound_targets = bound.data() + reloc_first[s];
+            for (size_t k = 0; k < in.sec->relocs.size(); ++k) {
+                if (bound_targets[k] == NO_TARGET) continue; // 动态重定位
+                const Relocation& reloc = in.sec->relocs[k];
+                const ResolvedSymbol& t = targets[bound_targets[k]];
+                // 可合并节的节符号：加数所指的片段合并后不一定还在原来的相对位置
+                uint64_t S = t.merge ? t.merge->addr_of(reloc.addend) - reloc.addend : t.addr;
+                apply_reloc(reloc.type, { in.out + reloc.offset, in.addr + reloc.offset,
+                    S, reloc.addend, &reloc.symbol });
+            }
+        }
+    });
+
+    if (options.verbose) {
+        auto done = chrono::steady_clock::now();
+        fprintf(stderr, "ld: pass 5: bound %zu relocations in %.2f ms, applied in %.2f ms (%zu threads)\n", bound.size(),
+            chrono::duration<double, milli>(apply_start - pass5_start).count(),
+            chrono::duration<double, milli>(done - apply_start).count(), pool.size());
     }
 
     if (!got_order.empty()) {
@@ -516,39 +1626,41 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
             });
         }
     }
+    time_trace_complete("pass 5: relocation", pass5_start);
 
     // ============================================================
-    // Pass 6: 生成程序头 (Task5核心要求，一对一映射，权限暂时rwx)
+    // Pass 6: 生成程序头 (每个段一个，以段中第一个输出节命名) 和节头
+    // 节头记录各输出节在段内的地址，FLE_exec 据此把节拷到段中
     // ============================================================
-    for (const auto& [s, sec] : exe.sections) {
-        uint32_t flags = PHF::R | PHF::W | PHF::X;
-        if (str_starts_with(s, ".text") || str_starts_with(s, ".plt")) {
-            flags = PHF::R | PHF::X;
-        } else if (str_starts_with(s, ".rodata")) {
-            flags = static_cast<uint32_t>(PHF::R);
-        } else if (str_starts_with(s, ".data") || str_starts_with(s, ".got") || str_starts_with(s, ".bss")) {
-            flags = PHF::R | PHF::W;
+    auto pass6_start = chrono::steady_clock::now();
+    for (const auto& segment : OUTPUT_SEGMENTS) {
+        const char* first = nullptr;
+        const char* last = nullptr;
+        for (const char* s : segment.sections) {
+            if (!exe.sections.count(s)) continue;
+            if (!first) first = s;
+            last = s;
         }
+        if (!first) continue;
         exe.phdrs.push_back({
-            s, sec_vaddr[s], sec_total_size[s],
-            flags
+            first, sec_vaddr[first], sec_vaddr[last] + sec_total_size[last] - sec_vaddr[first],
+            segment.flags
         });
     }
 
-    if (options.shared) {
-        exe.shdrs.clear();
-        size_t file_off = 0;
-        const vector<string> order = {".text", ".plt", ".rodata", ".data", ".got", ".bss"};
-        for (const auto& name : order) {
+    exe.shdrs.clear();
+    size_t file_off = 0;
+    for (const auto& segment : OUTPUT_SEGMENTS) {
+        for (const char* name : segment.sections) {
             if (!exe.sections.count(name)) {
                 continue;
             }
             uint32_t flags = 0;
             uint32_t type = 1;
             flags |= SHF::ALLOC;
-            if (str_starts_with(name, ".text") || str_starts_with(name, ".plt")) {
+            if (segment.flags & PHF::X) {
                 flags |= SHF::EXEC;
-            } else if (str_starts_with(name, ".data") || str_starts_with(name, ".got") || str_starts_with(name, ".bss")) {
+            } else if (segment.flags & PHF::W) {
                 flags |= SHF::WRITE;
             }
             if (str_starts_with(name, ".bss")) {
@@ -562,21 +1674,174 @@ FLEObject FLE_ld(const vector<FLEObject>& objects,
                 flags,
                 sec_vaddr[name],
                 file_off,
-                sec_total_size[name]
+                sec_total_size[name],
+                0,
+                sec_align[name]
             });
             file_off += sec_total_size[name];
         }
     }
+    time_trace_complete("pass 6: program headers", pass6_start);
 
     // ============================================================
     // 入口点处理
     // ============================================================
     if (!options.shared) {
         const string entry = options.entryPoint.empty() ? "_start" : options.entryPoint;
-        if (!symtab.count(entry)) {
+        auto entry_it = symtab.find(entry);
+        if (entry_it == symtab.end()) {
             throw runtime_error("Undefined entry: " + entry);
         }
-        exe.entry = symtab[entry].addr;
+        exe.entry = targets[entry_it->second].addr;
+    }
+
+    // ============================================================
+    // 链接映射 (-Map)：各输出节由哪些输入节组成、每个输入节定义了哪些符号
+    // ============================================================
+    if (!options.map_file.empty()) {
+        TimeTraceScope trace("link map", options.map_file);
+        LinkMap link_map;
+        link_map.output = exe.name;
+        link_map.entry = exe.entry;
+        link_map.shared = options.shared;
+        link_map.segments = exe.phdrs;
+        // 局部符号和胜出的全局/弱定义，列在定义它的输入节下 (被折叠的节的符号列在保留者下)；不列节符号
+        unordered_map<const FLESection*, vector<LinkMapSymbol>> sec_symbols;
+        for (uint32_t oi = 0; oi < objs.size(); ++oi) {
+            const FLEObject& obj = objs[oi];
+            for (const auto& sym : obj.symbols) {
+                if (sym.section.empty() || sym.name == sym.section) continue;
+                auto in_it = in2out.find({ obj.name, sym.section });
+                if (in_it == in2out.end()) continue;
+                if (sym.type != SymbolType::LOCAL && targets[symtab.at(sym.name)].object != oi) continue;
+                const InputSection& in = input_secs[in_it->second];
+                sec_symbols[in.sec].push_back({ sym.name, in.addr + sym.offset, sym.type });
+            }
+        }
+        for (auto& [sec, syms] : sec_symbols) {
+            stable_sort(syms.begin(), syms.end(), [](const auto& a, const auto& b) { return a.addr < b.addr; });
+        }
+
+        for (const auto& segment : OUTPUT_SEGMENTS) {
+            for (const char* name : segment.sections) {
+                if (!exe.sections.count(name)) continue;
+                LinkMapOutput out;
+                out.name = name;
+                out.addr = sec_vaddr[name];
+                out.size = sec_total_size[name];
+                out.align = sec_align[name];
+                auto synthetic = [&](string what, uint64_t addr, uint64_t size, uint64_t align) {
+                    LinkMapInput in;
+                    in.section = "<" + what + ">";
+                    in.addr = addr;
+                    in.size = size;
+                    in.align = align;
+                    out.inputs.push_back(move(in));
+                };
+                if (string_view(name) == ".rodata" && !merged.data.empty()) {
+                    synthetic("merged strings and constants from " + to_string(merged.inputs.size()) + " sections, "
+                            + to_string(merged.input_bytes) + " input bytes",
+                        out.addr, merged.data.size(), merged.align);
+                }
+                for (const auto& entry : layout) {
+                    if (string_view(entry.target) != name) continue;
+                    LinkMapInput in;
+                    in.file = file_of(*entry.obj);
+                    auto ar_it = selection.archive_of.find(entry.obj);
+                    if (ar_it != selection.archive_of.end()) {
+                        in.archive = ar_it->second->name;
+                    }
+                    in.section = entry.sec->name;
+                    in.addr = out.addr + entry.out_off;
+                    in.size = entry.size;
+                    in.align = entry.align;
+                    in.ordered = entry.priority != SIZE_MAX;
+                    auto sym_it = sec_symbols.find(entry.sec);
+                    if (sym_it != sec_symbols.end()) {
+                        in.symbols = move(sym_it->second);
+                    }
+                    out.inputs.push_back(move(in));
+                }
+                if (string_view(name) == ".plt" && !options.shared && !plt_order.empty()) {
+                    synthetic(to_string(plt_order.size()) + " PLT stubs", out.addr + sec_write_off[".plt"], plt_order.size() * 6, 1);
+                }
+                if (string_view(name) == ".got" && !got_order.empty()) {
+                    synthetic(to_string(got_order.size()) + " GOT entries", out.addr, got_order.size() * 8, 8);
+                }
+                link_map.sections.push_back(move(out));
+            }
+        }
+
+        for (const auto& f : folded) {
+            link_map.folded.push_back({ file_of(*f.obj), f.sec->name, f.size, file_of(*f.leader_obj) + ":" + f.leader->name });
+        }
+        link_map.discarded = move(gc_discarded);
+        if (!section_order.empty()) {
+            link_map.ordering = options.symbol_ordering.empty() ? "--call-graph-profile" : "--symbol-ordering-file";
+            link_map.ordered_sections = count_if(layout.begin(), layout.end(), [](const auto& e) { return e.priority != SIZE_MAX; });
+            link_map.clusters = options.symbol_ordering.empty() ? cluster_count : 0;
+            link_map.has_crossings = !call_graph.empty();
+            link_map.crossings_before = crossings_before;
+            link_map.crossings_after = crossings_after;
+        }
+        write_link_map(link_map, options.map_file);
+    }
+
+    // ============================================================
+    // 增量链接状态 (--incremental)：布局、全局符号决议结果、指向全局符号的重定位
+    // ============================================================
+    if (relinkable) {
+        TimeTraceScope trace("capture link state");
+        state->key = link_state_key(options);
+        for (const auto& obj : objects) {
+            state->has_archives |= obj.type == ".ar";
+        }
+        copy(begin(layout_vaddr), end(layout_vaddr), state->section_vaddr);
+
+        size_t next_sec = 0;
+        for (uint32_t oi = 0; oi < objs.size(); ++oi) {
+            const FLEObject& obj = objs[oi];
+            LinkStateObject record;
+            record.name = obj.name;
+            // 命令行上的目标文件直接位于 objects 中；归档成员不在
+            record.input = &obj >= objects.data() && &obj < objects.data() + objects.size()
+                ? static_cast<uint32_t>(&obj - objects.data())
+                : LINK_STATE_NONE;
+            record.section_first = static_cast<uint32_t>(next_sec);
+            for (; next_sec < input_secs.size() && input_secs[next_sec].obj == &obj; ++next_sec) {
+                const InputSection& in = input_secs[next_sec];
+                size_t size = get_section_size(obj, in.sec->name, *in.sec);
+                uint32_t output = static_cast<uint32_t>(
+                    find_if(begin(LINK_OUTPUT_SECTIONS), end(LINK_OUTPUT_SECTIONS),
+                        [&](const char* name) { return name == string_view(in.target); })
+                    - begin(LINK_OUTPUT_SECTIONS));
+                state->sections.push_back({ in.sec->name, output, in.out_off, size, incremental_capacity(size) });
+            }
+            record.section_count = static_cast<uint32_t>(next_sec - record.section_first);
+            record.local_first = local_first[oi];
+            record.local_count = local_first[oi + 1] - local_first[oi];
+            link_interface_hashes(obj, record.defined_hash, record.undefined_hash);
+            state->objects.push_back(record);
+        }
+
+        vector<uint32_t> global_of_target(targets.size(), LINK_STATE_NONE);
+        for (const auto& [name, rsym] : exported) {
+            global_of_target[symtab.at(name)] = static_cast<uint32_t>(state->globals.size());
+            state->globals.push_back({ name, rsym.type, rsym.addr, rsym.object });
+        }
+        state->got = got_order;
+
+        for (size_t s = 0; s < input_secs.size(); ++s) {
+            const InputSection& in = input_secs[s];
+            const uint32_t* bound_targets = bound.data() + reloc_first[s];
+            for (size_t k = 0; k < in.sec->relocs.size(); ++k) {
+                uint32_t target = bound_targets[k];
+                if (target == NO_TARGET || global_of_target[target] == LINK_STATE_NONE) continue;
+                const Relocation& reloc = in.sec->relocs[k];
+                state->sites.push_back({ static_cast<uint32_t>(s), global_of_target[target], reloc.type,
+                    in.out_off + reloc.offset, reloc.addend });
+            }
+        }
     }
 
     return exe;
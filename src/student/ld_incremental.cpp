@@ -0,0 +1,629 @@
+#include "fle.hpp"
+#include "fle_cache.hpp"
+#include "link_state.hpp"
+#include "mapped_file.hpp"
+#include "reloc_engine.hpp"
+#include "thread_pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <sys/stat.h>
+#include <unordered_map>
+#include <unistd.h>
+#include <vector>
+
+using namespace std;
+
+/* ============================================================
+ * 状态文件格式 (小端，定长字段 + 长度前缀字符串)
+ *   magic "FLELDST\0", 版本号, 然后依次是 LinkState 的各个字段
+ * 版本不符或读到一半出错都当作没有状态，做完整链接
+ * ============================================================ */
+static constexpr char STATE_MAGIC[8] = { 'F', 'L', 'E', 'L', 'D', 'S', 'T', '\0' };
+static constexpr uint32_t STATE_VERSION = 1;
+
+static string state_path(const LinkerOptions& options) {
+    return options.outputFile + ".ldstate";
+}
+
+class StateWriter {
+public:
+    template <typename T>
+    void put(T value) {
+        static_assert(is_trivially_copyable<T>::value, "plain values only");
+        bytes.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    }
+    void put_str(const string& s) {
+        put<uint32_t>(static_cast<uint32_t>(s.size()));
+        bytes += s;
+    }
+    void put_stamp(const LinkInputStamp& stamp) {
+        put_str(stamp.path);
+        put(stamp.size);
+        put(stamp.mtime_ns);
+        put(stamp.hash);
+    }
+
+    string bytes;
+};
+
+class StateReader {
+public:
+    explicit StateReader(string_view data) : data(data) {}
+
+    template <typename T>
+    T get() {
+        need(sizeof(T));
+        T value;
+        memcpy(&value, data.data() + pos, sizeof(T));
+        pos += sizeof(T);
+        return value;
+    }
+    string get_str() {
+        uint32_t len = get<uint32_t>();
+        need(len);
+        string s(data.substr(pos, len));
+        pos += len;
+        return s;
+    }
+    LinkInputStamp get_stamp() {
+        LinkInputStamp stamp;
+        stamp.path = get_str();
+        stamp.size = get<uint64_t>();
+        stamp.mtime_ns = get<int64_t>();
+        stamp.hash = get<uint64_t>();
+        return stamp;
+    }
+    // 表长，每项至少 min_bytes 字节；防止损坏的长度导致巨大的分配
+    size_t get_count(size_t min_bytes) {
+        uint64_t count = get<uint64_t>();
+        if (count > (data.size() - pos) / min_bytes) {
+            throw runtime_error("corrupt link state");
+        }
+        return static_cast<size_t>(count);
+    }
+    bool at_end() const { return pos == data.size(); }
+
+private:
+    string_view data;
+    size_t pos = 0;
+
+    void need(size_t n) const {
+        if (n > data.size() - pos) {
+            throw runtime_error("truncated link state");
+        }
+    }
+};
+
+static string serialize_state(const LinkState& state) {
+    StateWriter w;
+    w.bytes.append(STATE_MAGIC, sizeof(STATE_MAGIC));
+    w.put(STATE_VERSION);
+    w.put<uint8_t>(state.relinkable);
+    w.put_str(state.key);
+    w.put<uint8_t>(state.has_archives);
+    for (uint64_t vaddr : state.section_vaddr) {
+        w.put(vaddr);
+    }
+    w.put_stamp(state.output);
+    w.put<uint64_t>(state.inputs.size());
+    for (const auto& stamp : state.inputs) {
+        w.put_stamp(stamp);
+    }
+    w.put<uint64_t>(state.objects.size());
+    for (const auto& obj : state.objects) {
+        w.put_str(obj.name);
+        w.put(obj.input);
+        w.put(obj.section_first);
+        w.put(obj.section_count);
+        w.put(obj.local_first);
+        w.put(obj.local_count);
+        w.put(obj.defined_hash);
+        w.put(obj.undefined_hash);
+    }
+    w.put<uint64_t>(state.sections.size());
+    for (const auto& sec : state.sections) {
+        w.put_str(sec.name);
+        w.put(sec.output);
+        w.put(sec.out_off);
+        w.put(sec.size);
+        w.put(sec.capacity);
+    }
+    w.put<uint64_t>(state.globals.size());
+    for (const auto& sym : state.globals) {
+        w.put_str(sym.name);
+        w.put(static_cast<uint32_t>(sym.type));
+        w.put(sym.addr);
+        w.put(sym.object);
+    }
+    w.put<uint64_t>(state.got.size());
+    for (const auto& name : state.got) {
+        w.put_str(name);
+    }
+    w.put<uint64_t>(state.sites.size());
+    for (const auto& site : state.sites) {
+        w.put(site.section);
+        w.put(site.symbol);
+        w.put(static_cast<uint32_t>(site.type));
+        w.put(site.out_off);
+        w.put(site.addend);
+    }
+    return move(w.bytes);
+}
+
+static void deserialize_state(string_view data, LinkState& state) {
+    StateReader r(data);
+    char magic[sizeof(STATE_MAGIC)];
+    for (char& c : magic) {
+        c = r.get<char>();
+    }
+    if (memcmp(magic, STATE_MAGIC, sizeof(magic)) != 0 || r.get<uint32_t>() != STATE_VERSION) {
+        throw runtime_error("unrecognized link state");
+    }
+    state = LinkState();
+    state.relinkable = r.get<uint8_t>() != 0;
+    state.key = r.get_str();
+    state.has_archives = r.get<uint8_t>() != 0;
+    for (uint64_t& vaddr : state.section_vaddr) {
+        vaddr = r.get<uint64_t>();
+    }
+    state.output = r.get_stamp();
+    state.inputs.resize(r.get_count(28));
+    for (auto& stamp : state.inputs) {
+        stamp = r.get_stamp();
+    }
+    state.objects.resize(r.get_count(40));
+    for (auto& obj : state.objects) {
+        obj.name = r.get_str();
+        obj.input = r.get<uint32_t>();
+        obj.section_first = r.get<uint32_t>();
+        obj.section_count = r.get<uint32_t>();
+        obj.local_first = r.get<uint32_t>();
+        obj.local_count = r.get<uint32_t>();
+        obj.defined_hash = r.get<uint64_t>();
+        obj.undefined_hash = r.get<uint64_t>();
+        if (uint64_t(obj.section_first) + obj.section_count > UINT32_MAX) {
+            throw runtime_error("corrupt link state");
+        }
+    }
+    state.sections.resize(r.get_count(32));
+    for (auto& sec : state.sections) {
+        sec.name = r.get_str();
+        sec.output = r.get<uint32_t>();
+        sec.out_off = r.get<uint64_t>();
+        sec.size = r.get<uint64_t>();
+        sec.capacity = r.get<uint64_t>();
+        if (sec.output >= LINK_OUTPUT_SECTION_COUNT) {
+            throw runtime_error("corrupt link state");
+        }
+    }
+    state.globals.resize(r.get_count(20));
+    for (auto& sym : state.globals) {
+        sym.name = r.get_str();
+        sym.type = static_cast<SymbolType>(r.get<uint32_t>());
+        sym.addr = r.get<uint64_t>();
+        sym.object = r.get<uint32_t>();
+    }
+    state.got.resize(r.get_count(4));
+    for (auto& name : state.got) {
+        name = r.get_str();
+    }
+    state.sites.resize(r.get_count(28));
+    for (auto& site : state.sites) {
+        site.section = r.get<uint32_t>();
+        site.symbol = r.get<uint32_t>();
+        site.type = static_cast<RelocationType>(r.get<uint32_t>());
+        site.out_off = r.get<uint64_t>();
+        site.addend = r.get<int64_t>();
+        if (site.section >= state.sections.size() || site.symbol >= state.globals.size()
+            || site.type > RelocationType::R_X86_64_GOTPCREL) {
+            throw runtime_error("corrupt link state");
+        }
+    }
+    for (const auto& obj : state.objects) {
+        if (obj.section_first + obj.section_count > state.sections.size()) {
+            throw runtime_error("corrupt link state");
+        }
+    }
+    if (!r.at_end()) {
+        throw runtime_error("corrupt link state");
+    }
+}
+
+/* ============================================================
+ * 文件指纹
+ * ============================================================ */
+static bool stat_file(const string& path, LinkInputStamp& stamp) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) return false;
+    stamp.path = path;
+    stamp.size = static_cast<uint64_t>(st.st_size);
+    stamp.mtime_ns = static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+    return true;
+}
+
+static uint64_t hash_file(const string& path) {
+    return fle_content_hash(MappedFile::open(path)->text());
+}
+
+/* ============================================================
+ * 与 FLE_ld 共用的接口哈希和选项键
+ * ============================================================ */
+void link_interface_hashes(const FLEObject& obj, uint64_t& defined_hash, uint64_t& undefined_hash) {
+    vector<pair<string_view, SymbolType>> defined;
+    vector<string_view> undefined;
+    for (const auto& sym : obj.symbols) {
+        if (sym.type == SymbolType::LOCAL) continue;
+        if (sym.section.empty()) {
+            undefined.push_back(sym.name.str());
+        } else {
+            defined.push_back({ sym.name.str(), sym.type });
+        }
+    }
+    sort(defined.begin(), defined.end());
+    sort(undefined.begin(), undefined.end());
+    undefined.erase(unique(undefined.begin(), undefined.end()), undefined.end());
+
+    string text;
+    for (const auto& [name, type] : defined) {
+        text.append(name).push_back('\0');
+        text.push_back(static_cast<char>('0' + static_cast<int>(type)));
+    }
+    defined_hash = fle_content_hash(text);
+    text.clear();
+    for (const auto& name : undefined) {
+        text.append(name).push_back('\0');
+    }
+    undefined_hash = fle_content_hash(text);
+}
+
+string link_state_key(const LinkerOptions& options) {
+    return "entry=" + options.entryPoint + ";static=" + (options.is_static ? "1" : "0") + ";output="
+        + options.outputFile + ";align-functions=" + to_string(options.align_functions);
+}
+
+/* ============================================================
+ * 增量链接
+ * 1. 检查状态、选项、输入列表和上次的输出都还对得上，找出内容变化的输入
+ * 2. 变化的输入必须是命令行上的目标文件，符号接口不变，各节仍放得下
+ * 3. 更新这些对象定义的全局符号地址
+ * 4. 重拷它们的节 (余量清零)，重做节内全部重定位
+ * 5. 其它节中指向地址变化的全局符号的重定位就地重做
+ * 6. 替换这些对象的局部符号，更新全局符号和入口
+ * 任何一步不满足都返回 false，由调用者完整链接
+ * ============================================================ */
+bool FLE_ld_relink(LinkState& state, const vector<string>& input_paths, const LinkerOptions& options,
+    FLEObject& output, string& reason)
+{
+    auto start = chrono::steady_clock::now();
+    auto fail = [&](string why) {
+        reason = move(why);
+        return false;
+    };
+
+    if (!options.map_file.empty()) return fail("-Map needs a full link");
+
+    try {
+        {
+            shared_ptr<MappedFile> file;
+            try {
+                file = MappedFile::open(state_path(options));
+            } catch (const exception&) {
+                return fail("no previous link state");
+            }
+            deserialize_state(file->text(), state);
+        }
+        if (!state.relinkable) return fail("previous link cannot be relinked");
+        if (state.key != link_state_key(options)) return fail("options changed");
+        if (state.inputs.size() != input_paths.size()) return fail("input list changed");
+
+        LinkInputStamp output_now;
+        if (!stat_file(options.outputFile, output_now) || output_now.size != state.output.size
+            || output_now.mtime_ns != state.output.mtime_ns) {
+            return fail("output changed since the last link");
+        }
+
+        // 1. 大小和修改时间都没变的输入不读；变了再比内容 (按输入并行)
+        for (size_t i = 0; i < input_paths.size(); ++i) {
+            if (state.inputs[i].path != input_paths[i]) return fail("input list changed");
+        }
+        vector<char> content_changed(input_paths.size());
+        {
+            ThreadPool pool(options.threads);
+            pool.parallel_for(input_paths.size(), [&](size_t i) {
+                LinkInputStamp& old = state.inputs[i];
+                LinkInputStamp now;
+                if (!stat_file(input_paths[i], now)) {
+                    throw runtime_error("cannot stat " + input_paths[i]);
+                }
+                if (now.size == old.size && now.mtime_ns == old.mtime_ns) return;
+                now.hash = hash_file(input_paths[i]);
+                content_changed[i] = now.hash != old.hash;
+                old = now;
+            });
+        }
+        vector<size_t> changed;
+        for (size_t i = 0; i < input_paths.size(); ++i) {
+            if (content_changed[i]) changed.push_back(i);
+        }
+
+        // 2. 检查变化的对象
+        vector<uint32_t> object_of_input(input_paths.size(), LINK_STATE_NONE);
+        for (uint32_t o = 0; o < state.objects.size(); ++o) {
+            if (state.objects[o].input != LINK_STATE_NONE) {
+                object_of_input.at(state.objects[o].input) = o;
+            }
+        }
+        struct Update {
+            uint32_t object;
+            FLEObject obj;
+            vector<const FLESection*> secs; // 与 state.sections 中本对象的区间一一对应
+        };
+        vector<Update> updates;
+        for (size_t i : changed) {
+            const string& path = input_paths[i];
+            uint32_t o = object_of_input[i];
+            if (o == LINK_STATE_NONE) return fail(path + " is not an object file in the link");
+            LinkStateObject& record = state.objects[o];
+            Update u { o, load_fle(path), {} };
+            if (u.obj.type != ".obj" || u.obj.name != record.name) return fail(path + " is not an object file in the link");
+
+            uint64_t defined_hash, undefined_hash;
+            link_interface_hashes(u.obj, defined_hash, undefined_hash);
+            if (defined_hash != record.defined_hash) return fail("global symbols of " + path + " changed");
+            if (undefined_hash != record.undefined_hash && state.has_archives) {
+                return fail("undefined symbols of " + path + " changed");
+            }
+
+            for (const auto& [sec_name, sec] : u.obj.sections) {
+                if (!output_section_for(sec_name)) continue;
+                size_t n = u.secs.size();
+                if (n >= record.section_count || state.sections[record.section_first + n].name != sec_name) {
+                    return fail("sections of " + path + " changed");
+                }
+                const LinkStateSection& slot = state.sections[record.section_first + n];
+                if (get_section_size(u.obj, sec_name, sec) > slot.capacity) {
+                    return fail(sec_name + " of " + path + " outgrew its reserved space");
+                }
+                if (slot.out_off % get_section_align(u.obj, sec_name, options) != 0) {
+                    return fail(sec_name + " of " + path + " needs a larger alignment");
+                }
+                if (slot.output == LINK_BSS && !sec.relocs.empty()) {
+                    return fail("relocations in " + sec_name + " of " + path);
+                }
+                u.secs.push_back(&sec);
+            }
+            if (u.secs.size() != record.section_count) return fail("sections of " + path + " changed");
+            updates.push_back(move(u));
+        }
+
+        output = load_fle(options.outputFile);
+        output.name = options.outputFile;
+        uint8_t* out_data[LINK_OUTPUT_SECTION_COUNT] = {};
+        for (size_t t = 0; t < LINK_BSS; ++t) {
+            auto it = output.sections.find(LINK_OUTPUT_SECTIONS[t]);
+            if (it != output.sections.end()) {
+                out_data[t] = it->second.data.data(); // 拷出自己的一份，之后要覆盖原文件
+            }
+        }
+        for (const auto& u : updates) {
+            const LinkStateObject& record = state.objects[u.object];
+            for (uint32_t n = 0; n < record.section_count; ++n) {
+                const LinkStateSection& slot = state.sections[record.section_first + n];
+                if (slot.output != LINK_BSS && !out_data[slot.output]) {
+                    return fail("output lacks " + string(LINK_OUTPUT_SECTIONS[slot.output]));
+                }
+            }
+        }
+
+        // 3. 全局符号
+        unordered_map<InternedString, uint32_t> global_index;
+        global_index.reserve(state.globals.size());
+        for (uint32_t g = 0; g < state.globals.size(); ++g) {
+            global_index.emplace(state.globals[g].name, g);
+        }
+        auto section_slot = [&](const Update& u, const InternedString& name) -> const LinkStateSection* {
+            const LinkStateObject& record = state.objects[u.object];
+            for (uint32_t n = 0; n < record.section_count; ++n) {
+                if (state.sections[record.section_first + n].name == name) {
+                    return &state.sections[record.section_first + n];
+                }
+            }
+            return nullptr;
+        };
+        auto slot_addr = [&](const LinkStateSection& slot) {
+            return state.section_vaddr[slot.output] + slot.out_off;
+        };
+        vector<char> moved(state.globals.size());
+        for (const auto& u : updates) {
+            for (const auto& sym : u.obj.symbols) {
+                if (sym.section.empty() || sym.type == SymbolType::LOCAL) continue;
+                const LinkStateSection* slot = section_slot(u, sym.section);
+                auto it = global_index.find(sym.name);
+                if (!slot || it == global_index.end()) continue;
+                LinkStateSymbol& global = state.globals[it->second];
+                uint64_t addr = slot_addr(*slot) + sym.offset;
+                if (global.object == u.object && global.addr != addr) {
+                    global.addr = addr;
+                    moved[it->second] = 1;
+                }
+            }
+        }
+
+        // 4. 重拷变化的节并重做其中的重定位
+        unordered_map<InternedString, uint64_t> got_addr;
+        for (size_t i = 0; i < state.got.size(); ++i) {
+            got_addr[state.got[i]] = state.section_vaddr[LINK_GOT] + i * 8;
+        }
+        vector<char> section_changed(state.sections.size());
+        vector<LinkStateSite> new_sites;
+        RelocBatch batch;
+        size_t relinked_sections = 0;
+        for (const auto& u : updates) {
+            const LinkStateObject& record = state.objects[u.object];
+            unordered_map<InternedString, uint64_t> locals; // 同名的后定义者生效
+            for (const auto& sym : u.obj.symbols) {
+                if (sym.type != SymbolType::LOCAL || sym.section.empty()) continue;
+                if (const LinkStateSection* slot = section_slot(u, sym.section)) {
+                    locals[sym.name] = slot_addr(*slot) + sym.offset;
+                }
+            }
+
+            for (uint32_t n = 0; n < record.section_count; ++n) {
+                uint32_t s = record.section_first + n;
+                LinkStateSection& slot = state.sections[s];
+                const FLESection& sec = *u.secs[n];
+                section_changed[s] = 1;
+                slot.size = get_section_size(u.obj, slot.name, sec);
+                ++relinked_sections;
+
+                uint8_t* dst = out_data[slot.output] ? out_data[slot.output] + slot.out_off : nullptr;
+                if (dst) {
+                    size_t len = min<size_t>(sec.data.size(), slot.size);
+                    memcpy(dst, sec.data.data(), len);
+                    memset(dst + len, 0, slot.capacity - len);
+                }
+                for (const auto& reloc : sec.relocs) {
+                    if (reloc.type > RelocationType::R_X86_64_GOTPCREL) return fail("unsupported relocation");
+                    uint64_t P = slot_addr(slot) + reloc.offset;
+                    auto local_it = locals.find(reloc.symbol);
+                    auto global_it = local_it == locals.end() ? global_index.find(reloc.symbol) : global_index.end();
+                    bool defined = local_it != locals.end() || global_it != global_index.end();
+                    if (!defined) return fail("undefined symbol " + reloc.symbol);
+
+                    uint64_t S;
+                    if (reloc.type == RelocationType::R_X86_64_GOTPCREL) {
+                        auto got_it = got_addr.find(reloc.symbol);
+                        if (got_it == got_addr.end()) return fail("new GOT entry for " + reloc.symbol);
+                        S = got_it->second;
+                    } else if (local_it != locals.end()) {
+                        S = local_it->second;
+                    } else {
+                        S = state.globals[global_it->second].addr;
+                        new_sites.push_back({ s, global_it->second, reloc.type, slot.out_off + reloc.offset,
+                            reloc.addend });
+                    }
+                    batch.add(reloc.type, { dst + reloc.offset, P, S, reloc.addend, &reloc.symbol });
+                }
+            }
+        }
+
+        // 5. 其它节中指向移动了的全局符号的重定位
+        size_t reapplied = 0;
+        vector<LinkStateSite> sites;
+        sites.reserve(state.sites.size() + new_sites.size());
+        for (const auto& site : state.sites) {
+            if (section_changed[site.section]) continue; // 已按新内容重做
+            if (moved[site.symbol]) {
+                const LinkStateSection& slot = state.sections[site.section];
+                uint64_t P = state.section_vaddr[slot.output] + site.out_off;
+                batch.add(site.type, { out_data[slot.output] + site.out_off, P, state.globals[site.symbol].addr,
+                    site.addend, &state.globals[site.symbol].name });
+                ++reapplied;
+            }
+            sites.push_back(site);
+        }
+        sites.insert(sites.end(), new_sites.begin(), new_sites.end());
+        size_t applied = batch.size();
+        batch.apply();
+        state.sites = move(sites);
+
+        // 6. 符号表：变化对象的局部符号整段替换，其余原样保留
+        vector<int> update_of_object(state.objects.size(), -1);
+        for (size_t i = 0; i < updates.size(); ++i) {
+            update_of_object[updates[i].object] = static_cast<int>(i);
+        }
+        if (!updates.empty()) {
+            size_t locals_end = state.objects.empty() ? 0
+                : state.objects.back().local_first + state.objects.back().local_count;
+            if (locals_end > output.symbols.size()) return fail("output symbols do not match the link state");
+            vector<Symbol> symbols;
+            symbols.reserve(output.symbols.size());
+            for (uint32_t o = 0; o < state.objects.size(); ++o) {
+                LinkStateObject& record = state.objects[o];
+                uint32_t first = static_cast<uint32_t>(symbols.size());
+                if (update_of_object[o] < 0) {
+                    auto begin = output.symbols.begin() + record.local_first;
+                    symbols.insert(symbols.end(), begin, begin + record.local_count);
+                } else {
+                    const Update& u = updates[update_of_object[o]];
+                    for (const auto& sym : u.obj.symbols) {
+                        if (sym.type != SymbolType::LOCAL || sym.section.empty()) continue;
+                        if (const LinkStateSection* slot = section_slot(u, sym.section)) {
+                            symbols.push_back({ SymbolType::LOCAL, LINK_OUTPUT_SECTIONS[slot->output],
+                                slot->out_off + sym.offset, sym.size, make_local_name(u.obj.name, sym.name) });
+                        }
+                    }
+                }
+                record.local_first = first;
+                record.local_count = static_cast<uint32_t>(symbols.size()) - first;
+            }
+            symbols.insert(symbols.end(), output.symbols.begin() + locals_end, output.symbols.end());
+            output.symbols = move(symbols);
+        }
+        for (auto& sym : output.symbols) {
+            if (sym.type == SymbolType::LOCAL) continue;
+            auto it = global_index.find(sym.name);
+            if (it == global_index.end() || !moved[it->second]) continue;
+            uint64_t addr = state.globals[it->second].addr;
+            const char* sec = exported_section_for(addr, state.section_vaddr);
+            size_t t = find_if(begin(LINK_OUTPUT_SECTIONS), end(LINK_OUTPUT_SECTIONS),
+                           [&](const char* name) { return string_view(name) == sec; })
+                - begin(LINK_OUTPUT_SECTIONS);
+            sym.section = sec;
+            sym.offset = addr - state.section_vaddr[t];
+        }
+        auto entry_it = global_index.find(options.entryPoint.empty() ? "_start" : options.entryPoint);
+        if (entry_it == global_index.end()) return fail("entry symbol is not defined");
+        output.entry = state.globals[entry_it->second].addr;
+
+        if (options.verbose) {
+            fprintf(stderr,
+                "ld: incremental: relinked %zu of %zu inputs (%zu sections, %zu relocations, %zu outside changed "
+                "sections) in %.2f ms\n",
+                updates.size(), input_paths.size(), relinked_sections, applied, reapplied,
+                chrono::duration<double, milli>(chrono::steady_clock::now() - start).count());
+        }
+        return true;
+    } catch (const exception& e) {
+        return fail(e.what());
+    }
+}
+
+void save_link_state(LinkState& state, const vector<string>& input_paths, const LinkerOptions& options) {
+    // 完整链接后 inputs 为空：所有输入都要记指纹；增量链接已经更新过
+    if (state.inputs.size() != input_paths.size()) {
+        state.inputs.assign(input_paths.size(), {});
+        ThreadPool pool(options.threads);
+        pool.parallel_for(input_paths.size(), [&](size_t i) {
+            if (!stat_file(input_paths[i], state.inputs[i])) {
+                throw runtime_error("Cannot stat " + input_paths[i]);
+            }
+            state.inputs[i].hash = hash_file(input_paths[i]);
+        });
+    }
+    if (!stat_file(options.outputFile, state.output)) {
+        throw runtime_error("Cannot stat " + options.outputFile);
+    }
+
+    string path = state_path(options);
+    string temp = path + ".tmp-" + to_string(getpid());
+    string bytes = serialize_state(state);
+    {
+        ofstream out(temp, ios::binary | ios::trunc);
+        out.write(bytes.data(), bytes.size());
+        if (!out) {
+            unlink(temp.c_str());
+            throw runtime_error("Cannot write " + temp);
+        }
+    }
+    if (rename(temp.c_str(), path.c_str()) != 0) {
+        unlink(temp.c_str());
+        throw runtime_error("Cannot write " + path);
+    }
+}
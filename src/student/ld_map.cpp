@@ -0,0 +1,134 @@
+#define FMT_HEADER_ONLY
+#include "fle.hpp"
+#include "link_map.hpp"
+#include <algorithm>
+#include <fmt/format.h>
+#include <fstream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static string flags_string(uint32_t flags) {
+    string s;
+    s += flags & PHF::R ? 'R' : '-';
+    s += flags & PHF::W ? 'W' : '-';
+    s += flags & PHF::X ? 'X' : '-';
+    return s;
+}
+
+template <typename... T>
+static void put(fmt::memory_buffer& out, fmt::format_string<T...> format, T&&... args) {
+    fmt::format_to(back_inserter(out), format, forward<T>(args)...);
+}
+
+/* ============================================================
+ * 按输入文件 / 归档汇总的字节数，从大到小 (同样大小按名字)
+ * 链接器生成的内容 (合并区、PLT、GOT) 没有来源文件，以其说明单列一行
+ * ============================================================ */
+struct SizeRow {
+    string name;
+    uint64_t bytes = 0;
+    size_t count = 0;
+};
+
+static vector<SizeRow> sorted_rows(const map<string, SizeRow>& rows) {
+    vector<SizeRow> sorted;
+    for (const auto& [name, row] : rows) {
+        sorted.push_back(row);
+    }
+    stable_sort(sorted.begin(), sorted.end(), [](const auto& a, const auto& b) { return a.bytes > b.bytes; });
+    return sorted;
+}
+
+static void write_size_table(fmt::memory_buffer& out, const char* title, const char* count_name,
+                             const vector<SizeRow>& rows) {
+    put(out, "\n{}:\n  {:<10}  {:<8}  {}\n", title, "Bytes", count_name, "Name");
+    for (const auto& row : rows) {
+        put(out, "  {:<10}  {:<8}  {}\n", row.bytes, row.count, row.name);
+    }
+}
+
+void write_link_map(const LinkMap& map_info, const string& path) {
+    fmt::memory_buffer out;
+
+    put(out, "Link map for {} ({}", map_info.output, map_info.shared ? "shared library" : "executable");
+    if (!map_info.shared) {
+        put(out, ", entry {:#018x}", map_info.entry);
+    }
+    put(out, ")\n\nSegments:\n  {:<8}  {:<18}  {:<10}  {}\n", "Name", "Address", "Size", "Flags");
+    for (const auto& seg : map_info.segments) {
+        put(out, "  {:<8}  {:#018x}  {:#010x}  {}\n", seg.name, seg.vaddr, seg.size, flags_string(seg.flags));
+    }
+
+    // 输出节；输入节下面缩进列出它定义的符号。标 * 的节由排序提前
+    put(out, "\nOutput sections:\n");
+    for (const auto& sec : map_info.sections) {
+        put(out, "\n{:<8}  {:#018x}  {:#010x}  align {}\n", sec.name, sec.addr, sec.size, sec.align);
+        for (const auto& in : sec.inputs) {
+            string name = in.file.empty() ? in.section : in.file + ":" + in.section;
+            put(out, "  {}{:#018x}  {:#010x}  {}\n", in.ordered ? '*' : ' ', in.addr, in.size, name);
+            for (const auto& sym : in.symbols) {
+                const char* type = sym.type == SymbolType::LOCAL ? " (local)" : sym.type == SymbolType::WEAK ? " (weak)" : "";
+                put(out, "      {:#018x}  {}{}\n", sym.addr, sym.name, type);
+            }
+        }
+    }
+
+    if (!map_info.folded.empty()) {
+        put(out, "\nFolded sections (--icf):\n");
+        for (const auto& f : map_info.folded) {
+            put(out, "  {:#010x}  {}:{} -> {}\n", f.size, f.file, f.section, f.folded_into);
+        }
+    }
+    if (!map_info.discarded.empty()) {
+        put(out, "\nDiscarded sections (--gc-sections):\n");
+        for (const auto& d : map_info.discarded) {
+            put(out, "  {:#010x}  {}:{}\n", d.size, d.file, d.section);
+        }
+    }
+    if (!map_info.ordering.empty()) {
+        put(out, "\nSection ordering ({}):\n  {} sections placed first", map_info.ordering, map_info.ordered_sections);
+        if (map_info.clusters > 0) {
+            put(out, " in {} clusters", map_info.clusters);
+        }
+        put(out, "\n");
+        if (map_info.has_crossings) {
+            put(out, "  estimated page crossings: {} -> {}\n", map_info.crossings_before, map_info.crossings_after);
+        }
+    }
+
+    map<string, SizeRow> by_file;
+    map<string, SizeRow> by_archive;
+    map<string, set<string>> archive_members;
+    for (const auto& sec : map_info.sections) {
+        for (const auto& in : sec.inputs) {
+            const string& key = in.file.empty() ? in.section : in.file;
+            SizeRow& row = by_file[key];
+            row.name = key;
+            row.bytes += in.size;
+            ++row.count;
+            if (!in.archive.empty()) {
+                SizeRow& ar = by_archive[in.archive];
+                ar.name = in.archive;
+                ar.bytes += in.size;
+                archive_members[in.archive].insert(in.file);
+            }
+        }
+    }
+    for (auto& [name, row] : by_archive) {
+        row.count = archive_members[name].size();
+    }
+    write_size_table(out, "Size by input file", "Sections", sorted_rows(by_file));
+    if (!by_archive.empty()) {
+        write_size_table(out, "Size by archive", "Members", sorted_rows(by_archive));
+    }
+
+    ofstream file(path, ios::binary);
+    if (!file || !file.write(out.data(), static_cast<streamsize>(out.size()))) {
+        throw runtime_error("Cannot write link map: " + path);
+    }
+}
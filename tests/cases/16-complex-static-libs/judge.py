@@ -45,14 +45,16 @@ def extract_bytes_from_section(section_lines):
     return chunks
 
 def extract_text_chunks(fle_obj):
-    # Retrieve the list of lines for .text
-    lines = []
-    if "sections" in fle_obj and ".text" in fle_obj["sections"]:
-        lines = fle_obj["sections"][".text"]["data"]
-    elif ".text" in fle_obj:
-        lines = fle_obj[".text"]
-    
-    return extract_bytes_from_section(lines)
+    # Retrieve the lines of .text, or of every .text.* section when the
+    # object was compiled with -ffunction-sections
+    chunks = []
+    sections = fle_obj["sections"] if "sections" in fle_obj else fle_obj
+    for name, section in sections.items():
+        if name == ".text" or name.startswith(".text."):
+            lines = section["data"] if isinstance(section, dict) else section
+            chunks.extend(extract_bytes_from_section(lines))
+
+    return chunks
 
 def judge():
     try:
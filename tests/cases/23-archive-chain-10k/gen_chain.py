@@ -0,0 +1,48 @@
+#!/usr/bin/env python3
+"""
+Generate a static library whose members form one long dependency chain:
+link0 jumps to link1, link1 to link2, ... and the last one returns 42.
+Every member is only pulled in by the member before it, so selecting the
+whole chain takes one round per member.
+
+Usage: gen_chain.py <ar> <build_dir> <count>
+"""
+import json
+import subprocess
+import sys
+from pathlib import Path
+
+
+def member(i, count):
+    name = f"link{i}"
+    if i + 1 < count:
+        # jmp link{i+1}
+        lines = [f"📤: {name} 5 0", "🔢: e9", f"❓: .rel(link{i + 1} - 4)"]
+        size = 5
+    else:
+        # mov eax, 42; ret
+        lines = [f"📤: {name} 6 0", "🔢: b8 2a 00 00 00 c3"]
+        size = 6
+    return {
+        "type": ".obj",
+        "shdrs": [{"name": ".text", "type": 1, "flags": 1, "addr": 0, "offset": 0, "size": size}],
+        ".text": lines,
+    }
+
+
+def main():
+    ar, build_dir, count = sys.argv[1], Path(sys.argv[2]), int(sys.argv[3])
+    build_dir.mkdir(parents=True, exist_ok=True)
+    paths = []
+    # Reverse order: each member sits before the one that needs it
+    for i in reversed(range(count)):
+        path = build_dir / f"link{i}.fo"
+        path.write_text(json.dumps(member(i, count), ensure_ascii=False), encoding="utf-8")
+        paths.append(str(path))
+    subprocess.run([ar, str(build_dir / "libchain.fa")] + paths, check=True)
+    for path in paths:
+        Path(path).unlink()
+
+
+if __name__ == "__main__":
+    main()
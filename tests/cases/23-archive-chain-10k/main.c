@@ -0,0 +1,6 @@
+int link0();
+
+int main()
+{
+    return link0() == 42 ? 0 : 1;
+}
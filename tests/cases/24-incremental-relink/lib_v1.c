@@ -0,0 +1,15 @@
+#include "minilibc.h"
+
+// 第一版：scale 位于 get_value 之前
+static int base = 10;
+
+int scale(int x)
+{
+    return x * 2;
+}
+
+int get_value(void)
+{
+    printf("v1\n");
+    return scale(base) + 1;
+}
@@ -0,0 +1,17 @@
+#include "minilibc.h"
+
+// 第二版：符号接口和节都不变，但 scale 变长，get_value 的地址随之移动，
+// main.fo 中对 get_value 的调用也要重做
+static int base = 20;
+
+int scale(int x)
+{
+    volatile int factor = 2; // 不新增字符串，避免多出 .rodata.scale.* 节
+    return x * factor;
+}
+
+int get_value(void)
+{
+    printf("v2\n");
+    return scale(base) + 1;
+}
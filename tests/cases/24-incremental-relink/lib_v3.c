@@ -0,0 +1,20 @@
+#include "minilibc.h"
+
+// 第三版：新增全局符号 offset，符号接口变了，只能完整链接
+static int base = 30;
+
+int offset(void)
+{
+    return 2;
+}
+
+int scale(int x)
+{
+    return x * 2;
+}
+
+int get_value(void)
+{
+    printf("v3\n");
+    return scale(base) + offset();
+}
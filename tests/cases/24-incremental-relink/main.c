@@ -0,0 +1,10 @@
+#include "minilibc.h"
+
+int get_value(void);
+
+int main()
+{
+    int value = get_value();
+    printf("value: %d\n", value);
+    return value;
+}
@@ -0,0 +1,34 @@
+#!/usr/bin/env python3
+import json
+import sys
+
+KEPT = ["_start", "main", "keep_called", "op_add", "ops", "printf"]
+REMOVED = ["dead_func", "dead_table", "dead_calls_live"]
+
+
+def judge():
+    input_data = json.load(sys.stdin)
+    stdout = input_data.get("stdout", "")
+    if isinstance(stdout, bytes):
+        stdout = stdout.decode("utf-8", errors="ignore")
+
+    # "0000000000000000 T main"; 局部符号带 "obj::" 前缀，只看全局符号
+    names = set()
+    for line in stdout.strip().split("\n"):
+        parts = line.split()
+        if len(parts) == 3 and "::" not in parts[2]:
+            names.add(parts[2])
+
+    missing = [name for name in KEPT if name not in names]
+    if missing:
+        print(json.dumps({"success": False, "message": f"Reachable symbols were removed: {', '.join(missing)}"}))
+        return
+    leftover = [name for name in REMOVED if name in names]
+    if leftover:
+        print(json.dumps({"success": False, "message": f"Unreachable symbols were kept: {', '.join(leftover)}"}))
+        return
+    print(json.dumps({"success": True, "message": "Unreachable sections removed."}))
+
+
+if __name__ == "__main__":
+    judge()
@@ -0,0 +1,39 @@
+#include "minilibc.h"
+
+// 可达：main 直接调用
+__attribute__((noinline)) int keep_called(int x)
+{
+    return x * 3;
+}
+
+// 可达：只通过数据节里的函数指针引用
+__attribute__((noinline)) int op_add(int x)
+{
+    return x + 4;
+}
+
+int (*ops[])(int) = { op_add };
+
+static int counter;
+
+// 不可达：没有任何重定位指向它们
+int dead_func(void)
+{
+    return 7;
+}
+
+int dead_table[256] = { 1, 2, 3 };
+
+// 不可达：它引用了可达的函数，但没人引用它
+int dead_calls_live(void)
+{
+    return keep_called(dead_table[1]);
+}
+
+int main()
+{
+    counter++;
+    int value = ops[0](keep_called(10)) + counter;
+    printf("value: %d\n", value);
+    return value;
+}
@@ -0,0 +1,19 @@
+// 与 b.c 中的函数逐字节相同，只是名字不同 (模拟同一模板的多次实例化)
+
+__attribute__((noinline)) int square_a(int x)
+{
+    return x * x + 1;
+}
+
+// 互相递归：折叠时需要假设 even_a ≡ even_b 再验证 odd_a ≡ odd_b
+__attribute__((noinline)) int odd_a(int n);
+
+__attribute__((noinline)) int even_a(int n)
+{
+    return n == 0 ? 1 : 2 * odd_a(n - 1);
+}
+
+__attribute__((noinline)) int odd_a(int n)
+{
+    return n == 0 ? 0 : 3 * even_a(n - 1);
+}
@@ -0,0 +1,19 @@
+// 与 a.c 中的函数逐字节相同
+
+__attribute__((noinline)) int square_b(int x)
+{
+    return x * x + 1;
+}
+
+// 互相递归，见 a.c
+__attribute__((noinline)) int odd_b(int n);
+
+__attribute__((noinline)) int even_b(int n)
+{
+    return n == 0 ? 1 : 2 * odd_b(n - 1);
+}
+
+__attribute__((noinline)) int odd_b(int n)
+{
+    return n == 0 ? 0 : 3 * even_b(n - 1);
+}
@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+import json
+import os
+import sys
+
+
+def symbol_offsets(path):
+    """Global symbol name -> (section, offset) from an FLE executable"""
+    with open(path, "r", encoding="utf-8") as f:
+        fle = json.load(f)
+    offsets = {}
+    for section, lines in fle.items():
+        if not section.startswith(".") or not isinstance(lines, list):
+            continue
+        for line in lines:
+            if line.startswith("📤:") or line.startswith("📎:"):
+                name, _size, offset = line.split(":", 1)[1].split()
+                offsets[name] = (section, int(offset))
+    return offsets
+
+
+def judge():
+    input_data = json.load(sys.stdin)
+    build_dir = os.path.join(input_data["test_dir"], "build")
+
+    # (程序, 应当折叠到同一地址的符号对, 不能折叠的符号对)
+    expectations = [
+        ("program_all", [("square_a", "square_b"), ("even_a", "even_b"), ("odd_a", "odd_b")], []),
+        ("program_safe", [("even_a", "even_b"), ("odd_a", "odd_b")], [("square_a", "square_b")]),
+    ]
+    for program, folded, distinct in expectations:
+        try:
+            offsets = symbol_offsets(os.path.join(build_dir, program))
+        except Exception as e:
+            print(json.dumps({"success": False, "message": f"Failed to load {program}: {e}"}))
+            return
+        for a, b in folded + distinct:
+            if a not in offsets or b not in offsets:
+                print(json.dumps({"success": False, "message": f"{program}: missing symbol {a} or {b}"}))
+                return
+        for a, b in folded:
+            if offsets[a] != offsets[b]:
+                print(json.dumps({"success": False, "message": f"{program}: {a} and {b} were not folded"}))
+                return
+        for a, b in distinct:
+            if offsets[a] == offsets[b]:
+                print(json.dumps({"success": False, "message": f"{program}: {a} is address-taken but was folded"}))
+                return
+
+    print(json.dumps({"success": True, "message": "Identical sections folded."}))
+
+
+if __name__ == "__main__":
+    judge()
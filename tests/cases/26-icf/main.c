@@ -0,0 +1,16 @@
+#include "minilibc.h"
+
+int square_a(int x);
+int square_b(int x);
+int even_a(int n);
+int even_b(int n);
+
+// 取了 square_b 的地址：--icf=safe 不能把它和 square_a 折叠
+int (*volatile square_ptr)(int) = square_b;
+
+int main()
+{
+    int value = square_a(3) + square_ptr(4) + even_a(3) + even_b(4);
+    printf("value: %d\n", value);
+    return value;
+}
@@ -0,0 +1,38 @@
+#!/usr/bin/env python3
+import json
+import os
+import sys
+
+
+def rodata_bytes(path):
+    """Contents of .rodata in an FLE executable"""
+    with open(path, "r", encoding="utf-8") as f:
+        fle = json.load(f)
+    data = bytearray()
+    for line in fle.get(".rodata", []):
+        if line.startswith("🔢:"):
+            data += bytes.fromhex(line.split(":", 1)[1])
+    return bytes(data)
+
+
+def judge():
+    input_data = json.load(sys.stdin)
+    program = os.path.join(input_data["test_dir"], "build", "program")
+    try:
+        data = rodata_bytes(program)
+    except Exception as e:
+        print(json.dumps({"success": False, "message": f"Failed to load program: {e}"}))
+        return
+
+    # 两个目标文件里各有一份，"orld" 是 "world" 的后缀
+    for s in [b"hello world\0", b"orld\0"]:
+        count = data.count(s)
+        if count != 1:
+            print(json.dumps({"success": False, "message": f"{s!r} appears {count} times in .rodata"}))
+            return
+
+    print(json.dumps({"success": True, "message": "Duplicate strings merged."}))
+
+
+if __name__ == "__main__":
+    judge()
@@ -0,0 +1,15 @@
+#include "minilibc.h"
+
+const char* copy = "hello world";
+// "world" 的后缀，可以与之共用字节
+const char* tail = "orld";
+
+double scale(double x)
+{
+    return x * 2.5;
+}
+
+void show(void)
+{
+    print(copy, "|", tail, "|", "world", "\n", (char*)0);
+}
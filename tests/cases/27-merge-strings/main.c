@@ -0,0 +1,23 @@
+#include "minilibc.h"
+
+// 与 lib.c 中的字符串相同：合并后只留一份
+const char* greeting = "hello world";
+const char* world = "world";
+
+double scale(double x);
+void show(void);
+
+double zero = 0;
+
+double twice(double x)
+{
+    return x * 2.5 + 1.25;
+}
+
+int main()
+{
+    // world + 1 经节符号加偏移引用字符串中间
+    print(greeting, " ", world + 1, "\n", (char*)0);
+    show();
+    return (int)twice(zero) + (int)scale(2.0);
+}
@@ -0,0 +1,5 @@
+// 另一个对象里的函数，排序后应排到 main.c 的函数之前
+__attribute__((noinline)) int helper(int x)
+{
+    return x ^ 1;
+}
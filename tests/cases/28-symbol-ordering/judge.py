@@ -0,0 +1,54 @@
+#!/usr/bin/env python3
+import json
+import os
+import sys
+
+
+def symbol_offsets(path):
+    """Global symbol name -> (section, offset) from an FLE executable"""
+    with open(path, "r", encoding="utf-8") as f:
+        fle = json.load(f)
+    offsets = {}
+    for section, lines in fle.items():
+        if not section.startswith(".") or not isinstance(lines, list):
+            continue
+        for line in lines:
+            if line.startswith("📤:") or line.startswith("📎:"):
+                name, _size, offset = line.split(":", 1)[1].split()
+                offsets[name] = (section, int(offset))
+    return offsets
+
+
+def judge():
+    input_data = json.load(sys.stdin)
+    program = os.path.join(input_data["test_dir"], "build", "program")
+    try:
+        offsets = symbol_offsets(program)
+    except Exception as e:
+        print(json.dumps({"success": False, "message": f"Failed to load program: {e}"}))
+        return
+
+    # order.txt 中的顺序；没列出的符号都应排在它们之后
+    expectations = {
+        ".text": (["gamma", "helper", "main"], ["alpha", "beta", "_start"]),
+        ".rodata": (["table_b"], ["table_a"]),
+    }
+    for section, (ordered, rest) in expectations.items():
+        for name in ordered + rest:
+            if offsets.get(name, (None,))[0] != section:
+                print(json.dumps({"success": False, "message": f"{name} is not in {section}"}))
+                return
+        placed = [offsets[name][1] for name in ordered]
+        if placed != sorted(placed) or placed[0] != 0:
+            print(json.dumps({"success": False, "message": f"{section}: {ordered} not placed first in file order"}))
+            return
+        for name in rest:
+            if offsets[name][1] < placed[-1]:
+                print(json.dumps({"success": False, "message": f"{section}: {name} placed before ordered symbols"}))
+                return
+
+    print(json.dumps({"success": True, "message": "Ordered sections placed first."}))
+
+
+if __name__ == "__main__":
+    judge()
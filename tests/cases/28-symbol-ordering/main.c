@@ -0,0 +1,26 @@
+#include "minilibc.h"
+
+// 布局前按名字排序：alpha < beta < gamma < main < table_a < table_b
+__attribute__((noinline)) int alpha(int x)
+{
+    return x + 1;
+}
+
+__attribute__((noinline)) int beta(int x)
+{
+    return x * 3;
+}
+
+__attribute__((noinline)) int gamma(int x)
+{
+    return x - 2;
+}
+
+const int table_a[4] = { 1, 2, 3, 4 };
+const int table_b[4] = { 5, 6, 7, 8 };
+
+int main()
+{
+    volatile int i = 2;
+    return alpha(table_a[i]) + beta(table_b[i]) + gamma(i); // 4 + 21 + 0
+}
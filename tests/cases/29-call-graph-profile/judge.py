@@ -0,0 +1,51 @@
+#!/usr/bin/env python3
+import json
+import os
+import sys
+
+
+def symbol_offsets(path):
+    """Global symbol name -> (section, offset) from an FLE executable"""
+    with open(path, "r", encoding="utf-8") as f:
+        fle = json.load(f)
+    offsets = {}
+    for section, lines in fle.items():
+        if not section.startswith(".") or not isinstance(lines, list):
+            continue
+        for line in lines:
+            if line.startswith("📤:") or line.startswith("📎:"):
+                name, _size, offset = line.split(":", 1)[1].split()
+                offsets[name] = (section, int(offset))
+    return offsets
+
+
+def judge():
+    input_data = json.load(sys.stdin)
+    program = os.path.join(input_data["test_dir"], "build", "program")
+    try:
+        offsets = symbol_offsets(program)
+    except Exception as e:
+        print(json.dumps({"success": False, "message": f"Failed to load program: {e}"}))
+        return
+
+    # 热调用链按调用顺序排在一起，冷函数在后面
+    chain = ["main", "f1_hot", "f3_hot", "f5_hot"]
+    cold = ["f2_cold", "f4_cold"]
+    for name in chain + cold:
+        if offsets.get(name, (None,))[0] != ".text":
+            print(json.dumps({"success": False, "message": f"{name} is not in .text"}))
+            return
+    placed = [offsets[name][1] for name in chain]
+    if placed != sorted(placed) or placed[-1] - placed[0] >= 4096:
+        print(json.dumps({"success": False, "message": f"hot chain not clustered: {dict(zip(chain, placed))}"}))
+        return
+    for name in cold:
+        if placed[0] < offsets[name][1] < placed[-1]:
+            print(json.dumps({"success": False, "message": f"{name} placed inside the hot chain"}))
+            return
+
+    print(json.dumps({"success": True, "message": "Hot call chain clustered."}))
+
+
+if __name__ == "__main__":
+    judge()
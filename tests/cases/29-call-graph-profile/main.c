@@ -0,0 +1,38 @@
+// 按节名排序时热函数和冷函数交错，冷函数各占约 3 KB，热的调用链跨越多页
+#define COLD_PADDING __asm__ volatile(".skip 3000, 0x90")
+
+__attribute__((noinline)) int f5_hot(int x)
+{
+    return x + 5;
+}
+
+__attribute__((noinline)) int f4_cold(int x)
+{
+    COLD_PADDING;
+    return x - 4;
+}
+
+__attribute__((noinline)) int f3_hot(int x)
+{
+    return f5_hot(x) * 3;
+}
+
+__attribute__((noinline)) int f2_cold(int x)
+{
+    COLD_PADDING;
+    return x - 2;
+}
+
+__attribute__((noinline)) int f1_hot(int x)
+{
+    return f3_hot(x) + 1;
+}
+
+int main()
+{
+    volatile int x = 1;
+    if (x == 0) {
+        return f2_cold(x) + f4_cold(x);
+    }
+    return f1_hot(x); // (1 + 5) * 3 + 1
+}
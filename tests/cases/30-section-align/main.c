@@ -0,0 +1,21 @@
+_Alignas(64) int cache_line[16] = { 1 };
+_Alignas(32) const int vector_table[8] = { 1, 2, 3, 4, 5, 6, 7, 8 };
+_Alignas(16) long counters[4];
+
+int pad_func(int x);
+
+__attribute__((noinline)) int leaf(int x)
+{
+    return x * 7;
+}
+
+int main()
+{
+    int misaligned = 0;
+    misaligned |= ((unsigned long)cache_line % 64 != 0) << 0;
+    misaligned |= ((unsigned long)vector_table % 32 != 0) << 1;
+    misaligned |= ((unsigned long)counters % 16 != 0) << 2;
+    misaligned |= ((unsigned long)&leaf % 64 != 0) << 3;
+    misaligned |= ((unsigned long)&main % 64 != 0) << 4;
+    return misaligned ? misaligned : pad_func(leaf(cache_line[0] + vector_table[0])) + counters[0]; // 15
+}
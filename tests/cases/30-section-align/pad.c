@@ -0,0 +1,8 @@
+// 先链接的奇数大小的节，把后面的输入节推到未对齐的偏移上
+char pad_data[3] = { 1, 2, 3 };
+const char pad_rodata[5] = { 1, 2, 3, 4, 5 };
+
+int pad_func(int x)
+{
+    return x + 1;
+}
@@ -0,0 +1,50 @@
+#!/usr/bin/env python3
+import json
+import os
+import sys
+
+PAGE_SIZE = 4096
+R, W, X = 4, 2, 1
+# 段的权限 → 应当放在其中的输出节
+SEGMENTS = {R | X: [".text"], R: [".rodata"], R | W: [".data", ".bss"]}
+
+
+def fail(message):
+    print(json.dumps({"success": False, "message": message}))
+
+
+def judge():
+    input_data = json.load(sys.stdin)
+    program = os.path.join(input_data["test_dir"], "build", "program")
+    try:
+        with open(program, "r", encoding="utf-8") as f:
+            fle = json.load(f)
+    except Exception as e:
+        return fail(f"Failed to load program: {e}")
+
+    phdrs = fle.get("phdrs", [])
+    shdrs = {h["name"]: h for h in fle.get("shdrs", [])}
+    flags = sorted(p["flags"] for p in phdrs)
+    if flags != sorted(SEGMENTS):
+        return fail(f"expected one RX, one R and one RW segment, found flags {flags}")
+
+    for phdr in phdrs:
+        if phdr["vaddr"] % PAGE_SIZE != 0:
+            return fail(f"segment {phdr['name']} does not start on a page boundary")
+        start, end = phdr["vaddr"], phdr["vaddr"] + phdr["size"]
+        for name in SEGMENTS[phdr["flags"]]:
+            if name not in shdrs:
+                return fail(f"missing section header for {name}")
+            shdr = shdrs[name]
+            if not (start <= shdr["addr"] and shdr["addr"] + shdr["size"] <= end):
+                return fail(f"{name} is outside segment {phdr['name']}")
+
+    # 同一段内的节紧挨着放，不再各占一页
+    if shdrs[".bss"]["addr"] - (shdrs[".data"]["addr"] + shdrs[".data"]["size"]) >= PAGE_SIZE:
+        return fail(".bss is not packed after .data")
+
+    print(json.dumps({"success": True, "message": "Sections packed into RX, R and RW segments."}))
+
+
+if __name__ == "__main__":
+    judge()
@@ -0,0 +1,19 @@
+#include "minilibc.h"
+
+// 用到 .text、.rodata、.data 和 .bss，其中 counter 定义在另一个对象的 .bss 里
+extern int counter;
+int initialized = 40;
+int zeroed[64];
+const char message[] = "packed segments\n";
+
+__attribute__((noinline)) int bump(int* p)
+{
+    return ++*p;
+}
+
+int main()
+{
+    print(message, (char*)0);
+    zeroed[63] = 1;
+    return bump(&counter) + bump(&initialized) + zeroed[63]; // 1 + 41 + 1
+}
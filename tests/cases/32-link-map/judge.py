@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+import json
+import os
+import re
+import sys
+
+SECTION_RE = re.compile(r"^(\.\w+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+align (\d+)$")
+INPUT_RE = re.compile(r"^  [ *]0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+SYMBOL_RE = re.compile(r"^      0x([0-9a-f]+)\s+(\S+)")
+ROW_RE = re.compile(r"^  (\d+)\s+(\d+)\s+(\S.*)$")
+
+
+def symbol_addrs(path):
+    """Global symbol name -> address from an FLE executable"""
+    with open(path, "r", encoding="utf-8") as f:
+        fle = json.load(f)
+    base = {shdr["name"]: shdr["addr"] for shdr in fle["shdrs"]}
+    addrs = {}
+    for section, lines in fle.items():
+        if not section.startswith(".") or not isinstance(lines, list):
+            continue
+        for line in lines:
+            if line.startswith("📤:") or line.startswith("📎:"):
+                name, _size, offset = line.split(":", 1)[1].split()
+                addrs[name] = base[section] + int(offset)
+    return addrs
+
+
+def parse_map(path):
+    """(输出节 [(name, addr, size, [(addr, size, input, {symbol: addr})])], {表名: [(bytes, count, name)]})"""
+    sections, tables = [], {}
+    table = None
+    with open(path, "r", encoding="utf-8") as f:
+        for line in f.read().splitlines():
+            if line.startswith("Size by"):
+                table = tables.setdefault(line.rstrip(":"), [])
+            elif table is not None:
+                m = ROW_RE.match(line)
+                if m:
+                    table.append((int(m.group(1)), int(m.group(2)), m.group(3)))
+            elif m := SECTION_RE.match(line):
+                sections.append((m.group(1), int(m.group(2), 16), int(m.group(3), 16), []))
+            elif m := INPUT_RE.match(line):
+                sections[-1][3].append((int(m.group(1), 16), int(m.group(2), 16), m.group(3), {}))
+            elif m := SYMBOL_RE.match(line):
+                sections[-1][3][-1][3][m.group(2)] = int(m.group(1), 16)
+    return sections, tables
+
+
+def check(build):
+    sections, tables = parse_map(os.path.join(build, "program.map"))
+    addrs = symbol_addrs(os.path.join(build, "program"))
+
+    defined = {}
+    per_file = {}
+    for name, addr, size, inputs in sections:
+        end = addr
+        for in_addr, in_size, in_name, symbols in inputs:
+            if in_addr < end or in_addr + in_size > addr + size:
+                return f"{in_name} at {in_addr:#x} overlaps or lies outside {name}"
+            end = in_addr + in_size
+            key = in_name if in_name.startswith("<") else in_name.rsplit(":", 1)[0]
+            per_file[key] = per_file.get(key, 0) + in_size
+            defined.update(symbols)
+
+    member = "libtables.fa(tables.fo)"
+    for symbol in ["main", "sum_table", "big_table", "counter", "_start"]:
+        if symbol not in defined:
+            return f"symbol {symbol} is not listed in the map"
+        if defined[symbol] != addrs[symbol]:
+            return f"{symbol}: map says {defined[symbol]:#x}, program has {addrs[symbol]:#x}"
+    if not any(in_name.startswith(member + ":.rodata") and "big_table" in symbols
+               for _, _, _, inputs in sections for _, _, in_name, symbols in inputs):
+        return f"big_table is not attributed to {member}"
+    if "unused" in open(os.path.join(build, "program.map"), encoding="utf-8").read():
+        return "unselected archive member appears in the map"
+
+    files = tables.get("Size by input file", [])
+    if [row[2] for row in files] != [row[2] for row in sorted(files, key=lambda r: -r[0])]:
+        return "size by input file is not sorted by size"
+    if {row[2]: row[0] for row in files} != per_file:
+        return f"size by input file {files} does not match the input sections {per_file}"
+    archives = tables.get("Size by archive", [])
+    if archives != [(per_file[member], 1, "libtables.fa")]:
+        return f"unexpected size by archive: {archives}"
+    return None
+
+
+def judge():
+    input_data = json.load(sys.stdin)
+    try:
+        error = check(os.path.join(input_data["test_dir"], "build"))
+    except Exception as e:
+        error = f"Failed to check link map: {e}"
+    if error:
+        print(json.dumps({"success": False, "message": error}))
+    else:
+        print(json.dumps({"success": True, "message": "Link map matches the program."}))
+
+
+if __name__ == "__main__":
+    judge()
@@ -0,0 +1,8 @@
+extern int sum_table(void);
+extern int counter;
+
+int main()
+{
+    counter += 2;
+    return sum_table() + counter;
+}
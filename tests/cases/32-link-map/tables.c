@@ -0,0 +1,11 @@
+const int big_table[64] = { [0] = 1, [10] = 2, [63] = 4 };
+int counter = 5;
+
+int sum_table(void)
+{
+    int sum = 0;
+    for (int i = 0; i < 64; i++) {
+        sum += big_table[i];
+    }
+    return sum;
+}
@@ -0,0 +1,4 @@
+int unused_function(void)
+{
+    return 42;
+}
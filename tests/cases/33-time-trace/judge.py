@@ -0,0 +1,65 @@
+#!/usr/bin/env python3
+import json
+import os
+import sys
+
+# 每个工具的计时文件里至少要有这些事件
+EXPECTED = {
+    "cc-trace.json": ("cc", ["cc", "gcc", "execute_command"]),
+    "ld-trace.json": ("ld", ["ld", "load_fle", "select archive members", "FLE_ld", "pass 1: sizing",
+                             "pass 2: address assignment", "pass 3: merge", "pass 4: symbol resolution",
+                             "pass 5: relocation", "pass 6: program headers", "write output"]),
+    "exec-trace.json": ("exec", ["load_fle", "load", "relocate", "protect", "jump"]),
+}
+
+
+def check(path, process, names):
+    with open(path, "r", encoding="utf-8") as f:
+        events = json.load(f)["traceEvents"]
+    meta = [e for e in events if e.get("ph") == "M" and e.get("name") == "process_name"]
+    if not meta or meta[0]["args"]["name"] != process:
+        return f"{path}: missing process name {process}"
+    seen = set()
+    for e in events:
+        if e.get("ph") == "X":
+            if not all(isinstance(e.get(k), (int, float)) for k in ("ts", "dur", "pid", "tid")) or e["dur"] < 0:
+                return f"{path}: malformed complete event {e}"
+        elif e.get("ph") == "i":
+            if not isinstance(e.get("ts"), (int, float)):
+                return f"{path}: malformed instant event {e}"
+        elif e.get("ph") != "M":
+            return f"{path}: unexpected event phase {e.get('ph')}"
+        seen.add(e.get("name"))
+    missing = [name for name in names if name not in seen]
+    if missing:
+        return f"{path}: missing events {missing}"
+
+    # 各遍按顺序执行，互不重叠，且都落在 FLE_ld 之内
+    spans = {e["name"]: (e["ts"], e["ts"] + e["dur"]) for e in events if e.get("ph") == "X"}
+    if "FLE_ld" in spans:
+        passes = [spans[name] for name in names if name.startswith("pass ")]
+        begin, end = spans["FLE_ld"]
+        for (s1, e1), (s2, e2) in zip(passes, passes[1:]):
+            if e1 > s2 + 1:
+                return f"{path}: passes overlap or are out of order"
+        if passes[0][0] < begin - 1 or passes[-1][1] > end + 1:
+            return f"{path}: passes are not inside FLE_ld"
+    return None
+
+
+def judge():
+    input_data = json.load(sys.stdin)
+    build = os.path.join(input_data["test_dir"], "build")
+    for file, (process, names) in EXPECTED.items():
+        try:
+            error = check(os.path.join(build, file), process, names)
+        except Exception as e:
+            error = f"Failed to read {file}: {e}"
+        if error:
+            print(json.dumps({"success": False, "message": error}))
+            return
+    print(json.dumps({"success": True, "message": "Traces are valid trace_event JSON."}))
+
+
+if __name__ == "__main__":
+    judge()
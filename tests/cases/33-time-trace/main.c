@@ -0,0 +1,9 @@
+#include "minilibc.h"
+
+static const char message[] = "traced\n";
+
+int main()
+{
+    print(message, (char*)0);
+    return 7;
+}